@@ -1,111 +1,2676 @@
 #define CGAL_MESH_2_OPTIMIZER_VERBOSE
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
-#include <CGAL/Delaunay_mesh_face_base_2.h>
+#include <CGAL/Delaunay_mesh_face_base_with_circumcenter_2.h>
 #include <CGAL/Delaunay_mesh_vertex_base_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
 
 #include <CGAL/lloyd_optimize_mesh_2.h>
+#include <CGAL/odt_optimize_mesh_2.h>
+#include <CGAL/hilbert_sort.h>
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
-typedef CGAL::Delaunay_mesh_vertex_base_2<K> Vb;
-typedef CGAL::Delaunay_mesh_face_base_2<K> Fb;
+typedef CGAL::Triangulation_vertex_base_with_info_2<size_t, K> VbWithId;
+typedef CGAL::Delaunay_mesh_vertex_base_2<K, VbWithId> Vb;
+typedef CGAL::Delaunay_mesh_face_base_with_circumcenter_2<K> Fb;
 typedef CGAL::Triangulation_data_structure_2<Vb, Fb> Tds;
 typedef CGAL::Constrained_Delaunay_triangulation_2<K, Tds> CDT;
 
-bool stopOptimizing = false;
-bool skipSaving = false;
+std::atomic<bool> stopOptimizing(false);
+std::atomic<bool> skipSaving(false);
+
+/// Vertex ID for vertices that weren't in the input, like those created where
+/// constraints intersect.
+const size_t NO_VERTEX_ID = static_cast<size_t>(-1);
+
+//------------------------------------------------------------------------------
+/// \brief Layout of the to-xms file.
+//------------------------------------------------------------------------------
+enum class OutputFormat
+{
+	Text,    ///< Points, a "-" line, then triangles, one per line.
+	Binary,  ///< BinaryResultHeader, an xy double array, then a triangle array.
+	Compact  ///< BinaryResultHeader, then quantized, delta and varint encoded data.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Move computed for each vertex by the optimizer.
+//------------------------------------------------------------------------------
+enum class Smoother
+{
+	Lloyd, ///< Centroid of the vertex's clipped Voronoi cell.
+	Odt    ///< Area weighted circumcenter of the vertex's triangles.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Optimization parameters read from the header of a to-cgal file.
+//------------------------------------------------------------------------------
+struct JobParameters
+{
+	int iterations = 0;
+	int timeLimit = 0;
+	double convergenceRatio = 0;
+	double freezeBound = 0;
+	OutputFormat outputFormat = OutputFormat::Text;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Options given on the command line.
+//------------------------------------------------------------------------------
+struct ProgramOptions
+{
+	std::string directory;
+	std::string input;                 ///< Path or "-" for stdin. Overrides the directory.
+	std::string output;                ///< Path or "-" for stdout. Overrides the directory.
+	int controlIn = -1;                ///< Descriptor the cancel byte is read from.
+	int controlOut = -1;               ///< Descriptor status lines are written to.
+	bool outputFormatSet = false;      ///< Overrides the job's output format.
+	OutputFormat outputFormat = OutputFormat::Text;
+	int quantizationBits = 30;         ///< Resolution of compact coordinates.
+	bool server = false;               ///< Read job requests until told to quit.
+	std::vector<std::string> batchDirectories; ///< Job directories to run concurrently.
+	std::string manifest;              ///< File listing more batch job directories.
+	bool batch = false;
+	size_t batchThreads = 0;           ///< Concurrent batch jobs. 0 for one per hardware thread.
+	std::string cacheDirectory;        ///< Where to cache results. Empty for no cache.
+	uintmax_t cacheSize = uintmax_t(1024) << 20; ///< Limit on the cache's size, in bytes.
+	/// How each iteration applies its moves.
+	CGAL::Mesh_2::Move_update_policy updatePolicy = CGAL::Mesh_2::VERTEX_BY_VERTEX_MOVES;
+	bool activeSet = false;            ///< Only move vertices whose neighborhood changed.
+	double relaxation = 1.0;           ///< Over-relaxation factor of the moves.
+	int andersonWindow = 0;            ///< Iterations mixed by Anderson acceleration. 0 for none.
+	int levels = 1;                    ///< Levels of multilevel optimization. 1 for none.
+	Smoother smoother = Smoother::Lloyd; ///< Move computed for each vertex.
+	int lbfgsMemory = 0;               ///< Iterations remembered by L-BFGS. 0 for none.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Header of a binary to-cgal file.
+///
+/// A binary to-cgal file is little-endian and laid out as:
+/// - This header (56 bytes).
+/// - numPoints pairs of doubles, x then y.
+/// - numConstraints pairs of point indices, uint32 or uint64 depending on
+///   BINARY_FLAG_64BIT_INDICES.
+///
+/// BINARY_FLAG_NO_CROSSING_CONSTRAINTS promises that constraints only meet at
+/// their endpoints and pass through no other input point.
+/// BINARY_FLAG_BINARY_OUTPUT and BINARY_FLAG_COMPACT_OUTPUT select the format of
+/// the to-xms file written for the job.
+///
+/// The header is a multiple of 8 bytes long, so both arrays are naturally
+/// aligned when the file is mapped.
+//------------------------------------------------------------------------------
+struct BinaryJobHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	int32_t iterations;
+	int32_t timeLimit;
+	double convergenceRatio;
+	double freezeBound;
+	uint64_t numPoints;
+	uint64_t numConstraints;
+};
+static_assert(sizeof(BinaryJobHeader) == 56, "Unexpected binary header size");
+
+const char BINARY_JOB_MAGIC[8] = { 'X', 'M', 'S', 'C', 'G', 'A', 'L', 'B' };
+const uint32_t BINARY_JOB_VERSION = 1;
+const uint32_t BINARY_FLAG_64BIT_INDICES = 0x1;
+const uint32_t BINARY_FLAG_NO_CROSSING_CONSTRAINTS = 0x2;
+const uint32_t BINARY_FLAG_BINARY_OUTPUT = 0x4;
+const uint32_t BINARY_FLAG_COMPACT_OUTPUT = 0x8;
+
+//------------------------------------------------------------------------------
+/// \brief Header of a binary to-xms file.
+///
+/// A binary to-xms file is little-endian. With OutputFormat::Binary the header
+/// is followed by:
+/// - numPoints pairs of doubles, x then y.
+/// - numTriangles triples of point indices, uint32 or uint64 depending on
+///   RESULT_FLAG_64BIT_INDICES.
+///
+/// With OutputFormat::Compact (RESULT_FLAG_COMPACT) it is followed by:
+/// - Three doubles: originX, originY and step. A point is
+///   (originX + qx * step, originY + qy * step) for integers qx and qy.
+/// - For each point, qx and qy as differences from the previous point's, each
+///   zigzag and varint encoded.
+/// - For each triangle, in Hilbert order of their centroids and rotated so the
+///   smallest index comes first, that index as a zigzag varint difference from
+///   the previous triangle's first index, then the other two as zigzag varint
+///   differences from the first.
+//------------------------------------------------------------------------------
+struct BinaryResultHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t numPoints;
+	uint64_t numTriangles;
+};
+static_assert(sizeof(BinaryResultHeader) == 32, "Unexpected binary header size");
+
+const char BINARY_RESULT_MAGIC[8] = { 'C', 'G', 'A', 'L', 'X', 'M', 'S', 'B' };
+const uint32_t BINARY_RESULT_VERSION = 1;
+const uint32_t RESULT_FLAG_64BIT_INDICES = 0x1;
+const uint32_t RESULT_FLAG_COMPACT = 0x2;
+
+//------------------------------------------------------------------------------
+/// \brief Read-only memory mapping of a whole file.
+//------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { Close(); }
+
+	bool Open(const std::string& a_path);
+	void Close();
+
+	const char* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
+
+//------------------------------------------------------------------------------
+/// \brief Map a file into memory.
+/// \param a_path: Path to the file.
+/// \return Whether the file was mapped. Empty files can't be mapped.
+//------------------------------------------------------------------------------
+bool MappedFile::Open(const std::string& a_path)
+{
+	Close();
+#ifdef _WIN32
+	m_file = CreateFileA(a_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_fd = open(a_path.c_str(), O_RDONLY);
+	if (m_fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(m_fd, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>(info.st_size);
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	madvise(data, m_size, MADV_SEQUENTIAL);
+	m_data = static_cast<const char*>(data);
+#endif
+	if (m_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+} // MappedFile::Open
+
+//------------------------------------------------------------------------------
+/// \brief Unmap the file, if any.
+//------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+	if (m_fd >= 0)
+		close(m_fd);
+	m_fd = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+} // MappedFile::Close
+
+//------------------------------------------------------------------------------
+/// \brief Persistent threads that share the items of a parallel loop.
+//------------------------------------------------------------------------------
+class WorkerPool
+{
+public:
+	static WorkerPool& Instance();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool();
+
+	/// Number of threads that run items, including the calling thread.
+	size_t Size() const { return m_threads.size() + 1; }
+
+	void Run(size_t a_count, const std::function<void(size_t)>& a_function);
+
+private:
+	explicit WorkerPool(size_t a_numThreads);
+	void Work();
+	void RunItems();
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_running;              ///< Held by the thread whose loop is running.
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const std::function<void(size_t)>* m_function = nullptr;
+	size_t m_count = 0;
+	std::atomic<size_t> m_next{ 0 };
+	size_t m_busy = 0;
+	size_t m_generation = 0;
+	bool m_stopping = false;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Get the pool shared by the whole program.
+/// \return The pool, with one thread per hardware thread.
+//------------------------------------------------------------------------------
+WorkerPool& WorkerPool::Instance()
+{
+	static WorkerPool pool((std::max)(1u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+} // WorkerPool::Instance
+
+//------------------------------------------------------------------------------
+/// \brief Start the pool's threads.
+/// \param a_numThreads: Number of threads besides the caller of Run.
+//------------------------------------------------------------------------------
+WorkerPool::WorkerPool(size_t a_numThreads)
+{
+	for (size_t i = 0; i < a_numThreads; i++)
+	{
+		m_threads.emplace_back(&WorkerPool::Work, this);
+	}
+} // WorkerPool::WorkerPool
+
+//------------------------------------------------------------------------------
+/// \brief Stop the pool's threads.
+//------------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+} // WorkerPool::~WorkerPool
+
+//------------------------------------------------------------------------------
+/// \brief Call a function for every item in [0, a_count) and wait for them.
+///
+/// If another thread's loop is already running, as with concurrent batch jobs,
+/// the items are run on the calling thread instead.
+///
+/// \param a_count: Number of items.
+/// \param a_function: Function to call with each item's index. Calls happen
+///                    concurrently and in no particular order.
+//------------------------------------------------------------------------------
+void WorkerPool::Run(size_t a_count, const std::function<void(size_t)>& a_function)
+{
+	if (a_count == 0)
+		return;
+	std::unique_lock<std::mutex> running(m_running, std::defer_lock);
+	if (a_count == 1 || m_threads.empty() || !running.try_lock())
+	{
+		for (size_t i = 0; i < a_count; i++)
+		{
+			a_function(i);
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_function = &a_function;
+	m_count = a_count;
+	m_next = 0;
+	m_busy = m_threads.size() + 1;
+	m_generation++;
+	lock.unlock();
+	m_wake.notify_all();
+
+	RunItems();
+
+	lock.lock();
+	m_done.wait(lock, [this] { return m_busy == 0; });
+	m_function = nullptr;
+} // WorkerPool::Run
+
+//------------------------------------------------------------------------------
+/// \brief Claim and run items until there are none left.
+//------------------------------------------------------------------------------
+void WorkerPool::RunItems()
+{
+	for (size_t i = m_next++; i < m_count; i = m_next++)
+	{
+		(*m_function)(i);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (--m_busy == 0)
+		m_done.notify_all();
+} // WorkerPool::RunItems
+
+//------------------------------------------------------------------------------
+/// \brief Thread function: wait for a loop to be started, then help run it.
+//------------------------------------------------------------------------------
+void WorkerPool::Work()
+{
+	size_t generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stopping || m_generation != generation; });
+			if (m_stopping)
+				return;
+			generation = m_generation;
+		}
+		RunItems();
+	}
+} // WorkerPool::Work
+
+//------------------------------------------------------------------------------
+/// \brief Stream buffer that reads from or writes to a file descriptor.
+//------------------------------------------------------------------------------
+class FdStreambuf : public std::streambuf
+{
+public:
+	explicit FdStreambuf(int a_fd) : m_fd(a_fd) {}
+	~FdStreambuf() { sync(); }
+
+protected:
+	int_type underflow() override;
+	int_type overflow(int_type a_c) override;
+	int sync() override;
+
+private:
+	int m_fd;
+	char m_in[1];
+	std::string m_out;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Stream buffer that starts every line it passes on with a prefix.
+///
+/// Used in server and batch mode so status lines carry the job ID. Lines are
+/// passed on whole, under a_lock if given, so several jobs can share a target
+/// without their lines mixing.
+//------------------------------------------------------------------------------
+class PrefixStreambuf : public std::streambuf
+{
+public:
+	PrefixStreambuf(std::streambuf* a_target, const std::string& a_prefix,
+		std::mutex* a_lock = nullptr)
+	: m_target(a_target)
+	, m_prefix(a_prefix)
+	, m_lock(a_lock)
+	, m_line(a_prefix)
+	{
+	}
+	~PrefixStreambuf() { sync(); }
+
+protected:
+	int_type overflow(int_type a_c) override;
+	int sync() override;
+
+private:
+	std::streambuf* m_target;
+	std::string m_prefix;
+	std::mutex* m_lock;
+	std::string m_line;                ///< Prefix and the line so far.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Stream buffer that passes everything on and keeps a copy of it.
+//------------------------------------------------------------------------------
+class TeeStreambuf : public std::streambuf
+{
+public:
+	TeeStreambuf(std::streambuf* a_target, std::string& a_copy)
+	: m_target(a_target)
+	, m_copy(a_copy)
+	{
+	}
+
+protected:
+	int_type overflow(int_type a_c) override
+	{
+		if (traits_type::eq_int_type(a_c, traits_type::eof()))
+			return traits_type::not_eof(a_c);
+		m_copy.push_back(traits_type::to_char_type(a_c));
+		return m_target->sputc(traits_type::to_char_type(a_c));
+	}
+	std::streamsize xsputn(const char* a_data, std::streamsize a_size) override
+	{
+		m_copy.append(a_data, static_cast<size_t>(a_size));
+		return m_target->sputn(a_data, a_size);
+	}
+	int sync() override { return m_target->pubsync(); }
+
+private:
+	std::streambuf* m_target;
+	std::string& m_copy;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Read one character. Used for the cancel byte, so nothing is buffered.
+/// \return The character, or eof.
+//------------------------------------------------------------------------------
+FdStreambuf::int_type FdStreambuf::underflow()
+{
+#ifdef _WIN32
+	int count = _read(m_fd, m_in, 1);
+#else
+	ssize_t count = read(m_fd, m_in, 1);
+#endif
+	if (count <= 0)
+		return traits_type::eof();
+	setg(m_in, m_in, m_in + 1);
+	return traits_type::to_int_type(m_in[0]);
+} // FdStreambuf::underflow
+
+//------------------------------------------------------------------------------
+/// \brief Buffer one character, writing out complete lines.
+/// \param a_c: The character.
+/// \return The character, or eof on error.
+//------------------------------------------------------------------------------
+FdStreambuf::int_type FdStreambuf::overflow(int_type a_c)
+{
+	if (traits_type::eq_int_type(a_c, traits_type::eof()))
+		return sync() == 0 ? traits_type::not_eof(a_c) : traits_type::eof();
+	m_out.push_back(traits_type::to_char_type(a_c));
+	if (a_c == '\n' && sync() != 0)
+		return traits_type::eof();
+	return a_c;
+} // FdStreambuf::overflow
+
+//------------------------------------------------------------------------------
+/// \brief Write out everything buffered.
+/// \return 0 on success, -1 on error.
+//------------------------------------------------------------------------------
+int FdStreambuf::sync()
+{
+	size_t written = 0;
+	while (written < m_out.size())
+	{
+#ifdef _WIN32
+		int count = _write(m_fd, m_out.data() + written,
+			static_cast<unsigned>(m_out.size() - written));
+#else
+		ssize_t count = write(m_fd, m_out.data() + written, m_out.size() - written);
+#endif
+		if (count <= 0)
+			return -1;
+		written += count;
+	}
+	m_out.clear();
+	return 0;
+} // FdStreambuf::sync
+
+//------------------------------------------------------------------------------
+/// \brief Buffer one character, passing on complete lines.
+/// \param a_c: The character.
+/// \return The character, or eof on error.
+//------------------------------------------------------------------------------
+PrefixStreambuf::int_type PrefixStreambuf::overflow(int_type a_c)
+{
+	if (traits_type::eq_int_type(a_c, traits_type::eof()))
+		return sync() == 0 ? traits_type::not_eof(a_c) : traits_type::eof();
+	m_line.push_back(traits_type::to_char_type(a_c));
+	if (a_c == '\n' && sync() != 0)
+		return traits_type::eof();
+	return a_c;
+} // PrefixStreambuf::overflow
+
+//------------------------------------------------------------------------------
+/// \brief Pass on the buffered line, if anything follows its prefix.
+/// \return 0 on success, -1 on error.
+//------------------------------------------------------------------------------
+int PrefixStreambuf::sync()
+{
+	if (m_line.size() == m_prefix.size())
+		return 0;
+	std::unique_lock<std::mutex> lock;
+	if (m_lock)
+		lock = std::unique_lock<std::mutex>(*m_lock);
+	bool written = m_target->sputn(m_line.data(), m_line.size()) ==
+		static_cast<std::streamsize>(m_line.size()) && m_target->pubsync() == 0;
+	m_line.resize(m_prefix.size());
+	return written ? 0 : -1;
+} // PrefixStreambuf::sync
+
+//------------------------------------------------------------------------------
+/// \brief Watch for cancel request, then set stopOptimizing to true.
+/// \param a_in: Stream the cancel byte arrives on. '1' also skips saving.
+//------------------------------------------------------------------------------
+void WatchForCancel(std::istream* a_in)
+{
+	std::istream::int_type flag = a_in->get();
+	skipSaving = (flag == '1');
+	stopOptimizing = true;
+} // WatchForCancel
+
+//------------------------------------------------------------------------------
+/// \brief Points and constraints read from a to-cgal file, before meshing.
+///
+/// The arrays point into the file's contents, which are kept here, or into
+/// the arrays parsed from them.
+//------------------------------------------------------------------------------
+struct MeshInput
+{
+	const double* xy = nullptr;        ///< x then y for each point.
+	size_t numPoints = 0;
+	const void* constraints = nullptr; ///< Pairs of point indices.
+	size_t numConstraints = 0;
+	bool wideIndices = false;          ///< Indices are uint64_t rather than uint32_t.
+	bool noCrossings = false;          ///< See BINARY_FLAG_NO_CROSSING_CONSTRAINTS.
+
+	MappedFile file;
+	std::vector<double> contents;      ///< Contents read from a stream.
+	std::vector<double> parsedXy;
+	std::vector<uint64_t> parsedConstraints;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Build a mesh from point and constraint arrays.
+///
+/// Points are inserted in spatially sorted order, each located from the
+/// previous one. Constraints are then inserted between the resulting vertex
+/// handles, so no endpoint is ever located by coordinate. Each vertex's info
+/// is set to the index of the point that created it, or NO_VERTEX_ID.
+///
+/// \param a_xy: Point coordinates, x then y for each point.
+/// \param a_numPoints: Number of points in a_xy.
+/// \param a_constraints: Pairs of indices into the points.
+/// \param a_numConstraints: Number of pairs in a_constraints.
+/// \param a_noCrossings: Whether the input guarantees that constraints only
+///                       meet at their endpoints and contain no other points.
+///                       Constraints that are already Delaunay edges are then
+///                       marked directly instead of going through the CDT's
+///                       intersection handling.
+/// \param a_cdt: CDT to put mesh into.
+/// \param a_status: Stream status lines are written to.
+/// \return Whether every constraint referred to a valid point.
+//------------------------------------------------------------------------------
+template <typename Index>
+bool BuildMesh(const double* a_xy, size_t a_numPoints, const Index* a_constraints,
+	size_t a_numConstraints, bool a_noCrossings, CDT& a_cdt, std::ostream& a_status)
+{
+	typedef CGAL::Pointer_property_map<CDT::Point_2>::type PointMap;
+	typedef CGAL::Spatial_sort_traits_adapter_2<K, PointMap> SortTraits;
+
+	a_status << "status=loading-points" << std::endl;
+	std::vector<CDT::Point_2> points;
+	points.reserve(a_numPoints);
+	for (size_t i = 0; i < a_numPoints; i++)
+	{
+		points.emplace_back(a_xy[2 * i], a_xy[2 * i + 1]);
+	}
+
+	std::vector<size_t> order(a_numPoints);
+	for (size_t i = 0; i < a_numPoints; i++)
+	{
+		order[i] = i;
+	}
+	CGAL::spatial_sort(order.begin(), order.end(),
+		SortTraits(CGAL::make_property_map(points), a_cdt.geom_traits()));
+
+	std::vector<CDT::Vertex_handle> vertices(a_numPoints);
+	CDT::Face_handle hint;
+	for (size_t i : order)
+	{
+		vertices[i] = a_cdt.insert(points[i], hint);
+		hint = vertices[i]->face();
+	}
+
+	a_status << "status=loading-boundaries" << std::endl;
+	for (size_t i = 0; i < a_numConstraints; i++)
+	{
+		Index a = a_constraints[2 * i], b = a_constraints[2 * i + 1];
+		if (a >= a_numPoints || b >= a_numPoints)
+		{
+			std::cerr << "Constraint " << i << " refers to a missing point\n";
+			return false;
+		}
+
+		CDT::Vertex_handle va = vertices[a], vb = vertices[b];
+		if (va == vb)
+			continue;
+
+		CDT::Face_handle face;
+		int index;
+		if (a_noCrossings && a_cdt.dimension() == 2 && a_cdt.is_edge(va, vb, face, index))
+		{
+			face->set_constraint(index, true);
+			face->neighbor(index)->set_constraint(a_cdt.mirror_index(face, index), true);
+		}
+		else
+		{
+			a_cdt.insert_constraint(va, vb);
+		}
+	}
+
+	for (auto& vertex : a_cdt.finite_vertex_handles())
+	{
+		vertex->info() = NO_VERTEX_ID;
+	}
+	for (size_t i = 0; i < a_numPoints; i++)
+	{
+		if (vertices[i]->info() == NO_VERTEX_ID)
+			vertices[i]->info() = i;
+	}
+	a_status << "status=loaded" << std::endl;
+	return true;
+} // BuildMesh
+
+//------------------------------------------------------------------------------
+/// \brief Build a mesh from a loaded to-cgal file.
+/// \param a_input: The points and constraints.
+/// \param a_cdt: CDT to put mesh into.
+/// \param a_status: Stream status lines are written to.
+/// \return Whether every constraint referred to a valid point.
+//------------------------------------------------------------------------------
+bool BuildMesh(const MeshInput& a_input, CDT& a_cdt, std::ostream& a_status)
+{
+	if (a_input.wideIndices)
+	{
+		return BuildMesh(a_input.xy, a_input.numPoints,
+			static_cast<const uint64_t*>(a_input.constraints), a_input.numConstraints,
+			a_input.noCrossings, a_cdt, a_status);
+	}
+	return BuildMesh(a_input.xy, a_input.numPoints,
+		static_cast<const uint32_t*>(a_input.constraints), a_input.numConstraints,
+		a_input.noCrossings, a_cdt, a_status);
+} // BuildMesh
+
+//------------------------------------------------------------------------------
+/// \brief Check whether a character separates tokens in the text format.
+/// \param a_c: The character.
+/// \return Whether it is whitespace in the classic locale.
+//------------------------------------------------------------------------------
+inline bool IsSpace(char a_c)
+{
+	return a_c == ' ' || a_c == '\n' || a_c == '\t' || a_c == '\r' || a_c == '\v' ||
+		a_c == '\f';
+} // IsSpace
+
+//------------------------------------------------------------------------------
+/// \brief Parse the next whitespace-separated token as a number.
+///
+/// Accepts what stream extraction accepts for well-formed files, including a
+/// leading '+', but is independent of the locale.
+///
+/// \param a_cursor: Position to start at. Advanced past the token.
+/// \param a_end: End of the text.
+/// \param a_value: Receives the value.
+/// \return Whether a token was found and parsed completely.
+//------------------------------------------------------------------------------
+template <typename T>
+bool ParseToken(const char*& a_cursor, const char* a_end, T& a_value)
+{
+	while (a_cursor != a_end && IsSpace(*a_cursor))
+		a_cursor++;
+	if (a_cursor != a_end && *a_cursor == '+')
+		a_cursor++;
+
+	std::from_chars_result result = std::from_chars(a_cursor, a_end, a_value);
+	if (result.ec != std::errc() || (result.ptr != a_end && !IsSpace(*result.ptr)))
+		return false;
+	a_cursor = result.ptr;
+	return true;
+} // ParseToken
+
+//------------------------------------------------------------------------------
+/// \brief Move past the next whitespace-separated token without parsing it.
+/// \param a_cursor: Position to start at. Advanced past the token.
+/// \param a_end: End of the text.
+//------------------------------------------------------------------------------
+void SkipToken(const char*& a_cursor, const char* a_end)
+{
+	while (a_cursor != a_end && IsSpace(*a_cursor))
+		a_cursor++;
+	while (a_cursor != a_end && !IsSpace(*a_cursor))
+		a_cursor++;
+} // SkipToken
+
+//------------------------------------------------------------------------------
+/// \brief Count the whitespace-separated tokens in a range of text.
+/// \param a_begin: Start of the text.
+/// \param a_end: End of the text.
+/// \return The number of tokens.
+//------------------------------------------------------------------------------
+size_t CountTokens(const char* a_begin, const char* a_end)
+{
+	size_t count = 0;
+	bool inToken = false;
+	for (const char* c = a_begin; c != a_end; c++)
+	{
+		bool space = IsSpace(*c);
+		count += !space && !inToken;
+		inToken = !space;
+	}
+	return count;
+} // CountTokens
+
+//------------------------------------------------------------------------------
+/// \brief Load a mesh provided by XMS in the text format.
+///
+/// The body of the file is split into line-aligned chunks. The worker pool
+/// counts the tokens in each chunk, which tells every chunk where its tokens
+/// belong, then parses the chunks straight into the point and constraint
+/// arrays.
+///
+/// \param a_data: Contents of the file.
+/// \param a_size: Size of the contents.
+/// \param a_parameters: Receives the optimization parameters.
+/// \param a_input: Receives the points and constraints.
+/// \return Whether the file was valid.
+//------------------------------------------------------------------------------
+bool LoadTextMesh(const char* a_data, size_t a_size, JobParameters& a_parameters,
+	MeshInput& a_input)
+{
+	const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+	const char* cursor = a_data;
+	const char* end = cursor + a_size;
+	size_t numPoints = 0;
+	if (!ParseToken(cursor, end, a_parameters.iterations) ||
+		!ParseToken(cursor, end, a_parameters.timeLimit) ||
+		!ParseToken(cursor, end, a_parameters.convergenceRatio) ||
+		!ParseToken(cursor, end, a_parameters.freezeBound) ||
+		!ParseToken(cursor, end, numPoints))
+	{
+		std::cerr << "Invalid header in text file\n";
+		return false;
+	}
+
+	WorkerPool& pool = WorkerPool::Instance();
+	size_t numChunks = (std::min)(pool.Size() * 4, static_cast<size_t>(end - cursor) / MIN_CHUNK_SIZE);
+	numChunks = (std::max)(numChunks, size_t(1));
+	std::vector<const char*> chunks(numChunks + 1, end);
+	chunks[0] = cursor;
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		const char* split = (std::max)(chunks[i - 1], cursor + (end - cursor) / numChunks * i);
+		split = static_cast<const char*>(std::memchr(split, '\n', end - split));
+		chunks[i] = split ? split + 1 : end;
+	}
+
+	std::vector<size_t> firstToken(numChunks + 1, 0);
+	pool.Run(numChunks, [&](size_t i) {
+		firstToken[i + 1] = CountTokens(chunks[i], chunks[i + 1]);
+	});
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		firstToken[i + 1] += firstToken[i];
+	}
+
+	// The constraint count follows the point coordinates.
+	size_t countToken = 2 * numPoints, numConstraints = 0;
+	if (firstToken[numChunks] <= countToken)
+	{
+		std::cerr << "Text file ends before its constraint count\n";
+		return false;
+	}
+	size_t countChunk = std::upper_bound(firstToken.begin(), firstToken.end(), countToken) -
+		firstToken.begin() - 1;
+	cursor = chunks[countChunk];
+	for (size_t i = firstToken[countChunk]; i < countToken; i++)
+	{
+		SkipToken(cursor, end);
+	}
+	if (!ParseToken(cursor, end, numConstraints))
+	{
+		std::cerr << "Invalid constraint count in text file\n";
+		return false;
+	}
+	if (firstToken[numChunks] - countToken - 1 < 2 * numConstraints)
+	{
+		std::cerr << "Text file ends before its last constraint\n";
+		return false;
+	}
+
+	std::vector<double>& xy = a_input.parsedXy;
+	std::vector<uint64_t>& constraints = a_input.parsedConstraints;
+	xy.assign(2 * numPoints, 0.0);
+	constraints.assign(2 * numConstraints, 0);
+	size_t lastToken = countToken + 2 * numConstraints;
+	std::atomic<bool> valid(true);
+	pool.Run(numChunks, [&](size_t i) {
+		const char* chunkCursor = chunks[i];
+		const char* chunkEnd = chunks[i + 1];
+		size_t token = firstToken[i];
+		size_t last = (std::min)(firstToken[i + 1], lastToken + 1);
+		bool ok = true;
+		for (; ok && token < (std::min)(last, countToken); token++)
+		{
+			ok = ParseToken(chunkCursor, chunkEnd, xy[token]);
+		}
+		if (token == countToken && token < last)
+		{
+			SkipToken(chunkCursor, chunkEnd);
+			token++;
+		}
+		for (; ok && token < last; token++)
+		{
+			ok = ParseToken(chunkCursor, chunkEnd, constraints[token - countToken - 1]);
+		}
+		if (!ok)
+			valid = false;
+	});
+	if (!valid)
+	{
+		std::cerr << "Invalid number in text file\n";
+		return false;
+	}
+
+	a_input.xy = xy.data();
+	a_input.numPoints = numPoints;
+	a_input.constraints = constraints.data();
+	a_input.numConstraints = numConstraints;
+	a_input.wideIndices = true;
+	a_input.noCrossings = false;
+	return true;
+} // LoadTextMesh
+
+//------------------------------------------------------------------------------
+/// \brief Load a mesh from a binary to-cgal file.
+/// \param a_data: Contents of the file. Must be 8-byte aligned and outlive a_input.
+/// \param a_size: Size of the contents.
+/// \param a_parameters: Receives the optimization parameters.
+/// \param a_input: Receives the points and constraints.
+/// \return Whether the file was valid.
+//------------------------------------------------------------------------------
+bool LoadBinaryMesh(const char* a_data, size_t a_size, JobParameters& a_parameters,
+	MeshInput& a_input)
+{
+	BinaryJobHeader header;
+	if (a_size < sizeof(header))
+	{
+		std::cerr << "Binary file is too small for its header\n";
+		return false;
+	}
+	std::memcpy(&header, a_data, sizeof(header));
+	if (header.version != BINARY_JOB_VERSION)
+	{
+		std::cerr << "Unsupported binary file version: " << header.version << '\n';
+		return false;
+	}
+
+	bool wideIndices = (header.flags & BINARY_FLAG_64BIT_INDICES) != 0;
+	bool noCrossings = (header.flags & BINARY_FLAG_NO_CROSSING_CONSTRAINTS) != 0;
+	size_t indexSize = wideIndices ? sizeof(uint64_t) : sizeof(uint32_t);
+	size_t available = a_size - sizeof(header);
+	if (header.numPoints > available / (2 * sizeof(double)) ||
+		header.numConstraints > (available - header.numPoints * 2 * sizeof(double)) / (2 * indexSize))
+	{
+		std::cerr << "Binary file is too small for its point and constraint counts\n";
+		return false;
+	}
+
+	a_parameters.iterations = header.iterations;
+	a_parameters.timeLimit = header.timeLimit;
+	a_parameters.convergenceRatio = header.convergenceRatio;
+	a_parameters.freezeBound = header.freezeBound;
+	if (header.flags & BINARY_FLAG_COMPACT_OUTPUT)
+		a_parameters.outputFormat = OutputFormat::Compact;
+	else if (header.flags & BINARY_FLAG_BINARY_OUTPUT)
+		a_parameters.outputFormat = OutputFormat::Binary;
+
+	const char* data = a_data + sizeof(header);
+	a_input.xy = reinterpret_cast<const double*>(data);
+	a_input.numPoints = header.numPoints;
+	a_input.constraints = data + header.numPoints * 2 * sizeof(double);
+	a_input.numConstraints = header.numConstraints;
+	a_input.wideIndices = wideIndices;
+	a_input.noCrossings = noCrossings;
+	return true;
+} // LoadBinaryMesh
+
+//------------------------------------------------------------------------------
+/// \brief Load a mesh from a to-cgal file in either format.
+/// \param a_data: Contents of the file. Must be 8-byte aligned and outlive a_input.
+/// \param a_size: Size of the contents.
+/// \param a_parameters: Receives the optimization parameters.
+/// \param a_input: Receives the points and constraints.
+/// \return Whether the file was valid.
+//------------------------------------------------------------------------------
+bool LoadMesh(const char* a_data, size_t a_size, JobParameters& a_parameters,
+	MeshInput& a_input)
+{
+	if (a_size >= sizeof(BINARY_JOB_MAGIC) &&
+		std::memcmp(a_data, BINARY_JOB_MAGIC, sizeof(BINARY_JOB_MAGIC)) == 0)
+	{
+		return LoadBinaryMesh(a_data, a_size, a_parameters, a_input);
+	}
+	return LoadTextMesh(a_data, a_size, a_parameters, a_input);
+} // LoadMesh
+
+//------------------------------------------------------------------------------
+/// \brief Read a stream to its end.
+/// \param a_in: Stream to read, e.g. stdin or a named pipe.
+/// \param a_data: Receives the contents, as doubles so they are 8-byte aligned.
+/// \param a_size: Receives the number of bytes read.
+/// \return Whether the stream was read without error.
+//------------------------------------------------------------------------------
+bool ReadStream(std::istream& a_in, std::vector<double>& a_data, size_t& a_size)
+{
+	const size_t READ_SIZE = 1 << 20;
+
+	a_size = 0;
+	for (;;)
+	{
+		a_data.resize((a_size + READ_SIZE) / sizeof(double) + 1);
+		a_in.read(reinterpret_cast<char*>(a_data.data()) + a_size, READ_SIZE);
+		a_size += static_cast<size_t>(a_in.gcount());
+		if (!a_in)
+			return a_in.eof();
+	}
+} // ReadStream
+
+//------------------------------------------------------------------------------
+/// \brief Load a mesh from a file, named pipe or stdin.
+///
+/// Regular files are mapped. Anything else is read to its end.
+///
+/// \param a_path: Path to read, or "-" for stdin.
+/// \param a_parameters: Receives the optimization parameters.
+/// \param a_input: Receives the points and constraints, and keeps the contents.
+/// \return Whether the input could be read and was valid.
+//------------------------------------------------------------------------------
+bool LoadInput(const std::string& a_path, JobParameters& a_parameters, MeshInput& a_input)
+{
+	std::error_code error;
+	if (a_path != "-" && std::filesystem::is_regular_file(a_path, error))
+	{
+		if (!a_input.file.Open(a_path))
+		{
+			std::cerr << "Unable to open file: " << a_path << '\n';
+			return false;
+		}
+		return LoadMesh(a_input.file.Data(), a_input.file.Size(), a_parameters, a_input);
+	}
+
+	std::ifstream file;
+	std::istream* in = &std::cin;
+	if (a_path != "-")
+	{
+		file.open(a_path, std::ios::binary);
+		in = &file;
+	}
+#ifdef _WIN32
+	else
+	{
+		_setmode(_fileno(stdin), _O_BINARY);
+	}
+#endif
+	size_t size = 0;
+	if (!*in || !ReadStream(*in, a_input.contents, size))
+	{
+		std::cerr << "Unable to read: " << a_path << '\n';
+		return false;
+	}
+	return LoadMesh(reinterpret_cast<const char*>(a_input.contents.data()), size, a_parameters,
+		a_input);
+} // LoadInput
+
+//------------------------------------------------------------------------------
+/// \brief Number the vertices of a mesh for output.
+///
+/// Vertices are ordered by the IDs they were loaded with, followed by any
+/// vertices that weren't in the input. Each vertex's info is replaced with its
+/// index in the output.
+///
+/// \param a_cdt: Mesh to number.
+/// \return The vertices in output order.
+//------------------------------------------------------------------------------
+std::vector<CDT::Vertex_handle> NumberVertices(CDT& a_cdt)
+{
+	std::vector<CDT::Vertex_handle> vertices;
+	std::vector<CDT::Vertex_handle> extraVertices;
+	for (auto& vertex : a_cdt.finite_vertex_handles())
+	{
+		size_t id = vertex->info();
+		if (id == NO_VERTEX_ID)
+		{
+			extraVertices.push_back(vertex);
+			continue;
+		}
+		if (id >= vertices.size())
+			vertices.resize(id + 1);
+		if (vertices[id] == CDT::Vertex_handle())
+			vertices[id] = vertex;
+		else
+			extraVertices.push_back(vertex);
+	}
+
+	vertices.erase(std::remove(vertices.begin(), vertices.end(), CDT::Vertex_handle()),
+		vertices.end());
+	vertices.insert(vertices.end(), extraVertices.begin(), extraVertices.end());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i]->info() = i;
+	}
+	return vertices;
+} // NumberVertices
+
+//------------------------------------------------------------------------------
+/// \brief Format items in parallel blocks and write the blocks in order.
+/// \param a_count: Number of items.
+/// \param a_maxItemSize: Upper bound on the characters written per item.
+/// \param a_format: Function that writes item i starting at a pointer and
+///                  returns the end of what it wrote.
+/// \param a_out: Stream to write to.
+//------------------------------------------------------------------------------
+template <typename Formatter>
+void WriteBlocks(size_t a_count, size_t a_maxItemSize, const Formatter& a_format,
+	std::ostream& a_out)
+{
+	const size_t ITEMS_PER_BLOCK = 1 << 16;
+
+	WorkerPool& pool = WorkerPool::Instance();
+	size_t numBlocks = (a_count + ITEMS_PER_BLOCK - 1) / ITEMS_PER_BLOCK;
+	size_t blocksPerRound = 2 * pool.Size();
+	std::vector<std::vector<char>> buffers(blocksPerRound);
+	std::vector<size_t> sizes(blocksPerRound);
+	for (size_t first = 0; first < numBlocks; first += blocksPerRound)
+	{
+		size_t roundBlocks = (std::min)(blocksPerRound, numBlocks - first);
+		pool.Run(roundBlocks, [&](size_t i) {
+			size_t begin = (first + i) * ITEMS_PER_BLOCK;
+			size_t end = (std::min)(begin + ITEMS_PER_BLOCK, a_count);
+			std::vector<char>& buffer = buffers[i];
+			buffer.resize((end - begin) * a_maxItemSize);
+			char* cursor = buffer.data();
+			for (size_t item = begin; item < end; item++)
+			{
+				cursor = a_format(item, cursor);
+			}
+			sizes[i] = cursor - buffer.data();
+		});
+		for (size_t i = 0; i < roundBlocks; i++)
+		{
+			a_out.write(buffers[i].data(), sizes[i]);
+		}
+	}
+} // WriteBlocks
+
+//------------------------------------------------------------------------------
+/// \brief Write a mesh in the text format.
+///
+/// Coordinates are written with the shortest representation that reads back
+/// as the same double, so the text is as exact as the binary formats.
+///
+/// \param a_cdt: Mesh to save.
+/// \param a_vertices: Vertices in output order.
+/// \param a_out: Stream to write to.
+/// \param a_status: Stream status lines are written to.
+//------------------------------------------------------------------------------
+void WriteTextMesh(CDT& a_cdt, const std::vector<CDT::Vertex_handle>& a_vertices,
+	std::ostream& a_out, std::ostream& a_status)
+{
+	// Longest shortest-round-trip double, e.g. -2.2250738585072014e-308.
+	const size_t MAX_DOUBLE_SIZE = 24;
+	const size_t MAX_INDEX_SIZE = 20;
+
+	a_status << "status=saving-points" << std::endl;
+	WriteBlocks(a_vertices.size(), 2 * MAX_DOUBLE_SIZE + 2, [&](size_t a_i, char* a_cursor) {
+		const CDT::Point_2& point = a_vertices[a_i]->point();
+		a_cursor = std::to_chars(a_cursor, a_cursor + MAX_DOUBLE_SIZE, point.x()).ptr;
+		*a_cursor++ = ' ';
+		a_cursor = std::to_chars(a_cursor, a_cursor + MAX_DOUBLE_SIZE, point.y()).ptr;
+		*a_cursor++ = '\n';
+		return a_cursor;
+	}, a_out);
+
+	a_status << "status=saving-edges" << std::endl;
+	a_out << "-\n";
+	std::vector<CDT::Face_handle> faces;
+	faces.reserve(a_cdt.number_of_faces());
+	for (auto& face : a_cdt.finite_face_handles())
+	{
+		faces.push_back(face);
+	}
+	WriteBlocks(faces.size(), 3 * MAX_INDEX_SIZE + 3, [&](size_t a_i, char* a_cursor) {
+		for (int v = 0; v < 3; v++)
+		{
+			a_cursor = std::to_chars(a_cursor, a_cursor + MAX_INDEX_SIZE,
+				faces[a_i]->vertex(v)->info()).ptr;
+			*a_cursor++ = v < 2 ? ' ' : '\n';
+		}
+		return a_cursor;
+	}, a_out);
+} // WriteTextMesh
+
+//------------------------------------------------------------------------------
+/// \brief Append raw bytes to a buffer.
+/// \param a_buffer: Buffer to append to.
+/// \param a_data: Bytes to append.
+/// \param a_size: Number of bytes.
+//------------------------------------------------------------------------------
+void AppendBytes(std::vector<char>& a_buffer, const void* a_data, size_t a_size)
+{
+	const char* data = static_cast<const char*>(a_data);
+	a_buffer.insert(a_buffer.end(), data, data + a_size);
+} // AppendBytes
+
+//------------------------------------------------------------------------------
+/// \brief Append a signed value as a zigzag varint.
+/// \param a_buffer: Buffer to append to.
+/// \param a_value: Value to append.
+//------------------------------------------------------------------------------
+void AppendZigZag(std::vector<char>& a_buffer, int64_t a_value)
+{
+	uint64_t value = (static_cast<uint64_t>(a_value) << 1) ^ static_cast<uint64_t>(a_value >> 63);
+	while (value >= 0x80)
+	{
+		a_buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	a_buffer.push_back(static_cast<char>(value));
+} // AppendZigZag
+
+//------------------------------------------------------------------------------
+/// \brief Append the compact point and triangle encoding to a buffer.
+/// \param a_cdt: Mesh to save.
+/// \param a_vertices: Vertices in output order.
+/// \param a_quantizationBits: Number of bits used to resolve the larger side of
+///                            the bounding box.
+/// \param a_buffer: Buffer to append to.
+/// \param a_status: Stream status lines are written to.
+//------------------------------------------------------------------------------
+void AppendCompactMesh(CDT& a_cdt, const std::vector<CDT::Vertex_handle>& a_vertices,
+	int a_quantizationBits, std::vector<char>& a_buffer, std::ostream& a_status)
+{
+	typedef CGAL::Pointer_property_map<CDT::Point_2>::type PointMap;
+	typedef CGAL::Spatial_sort_traits_adapter_2<K, PointMap> SortTraits;
+
+	a_status << "status=saving-points" << std::endl;
+	double origin[2] = { 0, 0 }, step = 1;
+	if (!a_vertices.empty())
+	{
+		CGAL::Bbox_2 box = a_vertices.front()->point().bbox();
+		for (auto& vertex : a_vertices)
+		{
+			box += vertex->point().bbox();
+		}
+		double extent = (std::max)(box.xmax() - box.xmin(), box.ymax() - box.ymin());
+		origin[0] = box.xmin();
+		origin[1] = box.ymin();
+		if (extent > 0)
+			step = std::ldexp(extent, -a_quantizationBits);
+	}
+	AppendBytes(a_buffer, origin, sizeof(origin));
+	AppendBytes(a_buffer, &step, sizeof(step));
+
+	int64_t previous[2] = { 0, 0 };
+	for (auto& vertex : a_vertices)
+	{
+		int64_t q[2] = { std::llround((vertex->point().x() - origin[0]) / step),
+			std::llround((vertex->point().y() - origin[1]) / step) };
+		AppendZigZag(a_buffer, q[0] - previous[0]);
+		AppendZigZag(a_buffer, q[1] - previous[1]);
+		previous[0] = q[0];
+		previous[1] = q[1];
+	}
+
+	a_status << "status=saving-edges" << std::endl;
+	std::vector<CDT::Face_handle> faces;
+	std::vector<CDT::Point_2> centroids;
+	faces.reserve(a_cdt.number_of_faces());
+	centroids.reserve(a_cdt.number_of_faces());
+	for (auto& face : a_cdt.finite_face_handles())
+	{
+		faces.push_back(face);
+		centroids.push_back(CGAL::centroid(a_cdt.triangle(face)));
+	}
+	std::vector<size_t> order(faces.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	CGAL::hilbert_sort(order.begin(), order.end(),
+		SortTraits(CGAL::make_property_map(centroids), a_cdt.geom_traits()));
+
+	int64_t previousFirst = 0;
+	for (size_t i : order)
+	{
+		int64_t ids[3] = { static_cast<int64_t>(faces[i]->vertex(0)->info()),
+			static_cast<int64_t>(faces[i]->vertex(1)->info()),
+			static_cast<int64_t>(faces[i]->vertex(2)->info()) };
+		int first = static_cast<int>(std::min_element(ids, ids + 3) - ids);
+		int64_t a = ids[first], b = ids[(first + 1) % 3], c = ids[(first + 2) % 3];
+		AppendZigZag(a_buffer, a - previousFirst);
+		AppendZigZag(a_buffer, b - a);
+		AppendZigZag(a_buffer, c - a);
+		previousFirst = a;
+	}
+} // AppendCompactMesh
+
+//------------------------------------------------------------------------------
+/// \brief Append the raw point and triangle arrays to a buffer.
+/// \param a_cdt: Mesh to save.
+/// \param a_vertices: Vertices in output order.
+/// \param a_buffer: Buffer to append to.
+/// \param a_status: Stream status lines are written to.
+//------------------------------------------------------------------------------
+template <typename Index>
+void AppendBinaryMesh(CDT& a_cdt, const std::vector<CDT::Vertex_handle>& a_vertices,
+	std::vector<char>& a_buffer, std::ostream& a_status)
+{
+	a_status << "status=saving-points" << std::endl;
+	size_t offset = a_buffer.size();
+	a_buffer.resize(offset + a_vertices.size() * 2 * sizeof(double));
+	double* xy = reinterpret_cast<double*>(a_buffer.data() + offset);
+	for (auto& vertex : a_vertices)
+	{
+		*xy++ = vertex->point().x();
+		*xy++ = vertex->point().y();
+	}
+
+	a_status << "status=saving-edges" << std::endl;
+	offset = a_buffer.size();
+	a_buffer.resize(offset + a_cdt.number_of_faces() * 3 * sizeof(Index));
+	Index* ids = reinterpret_cast<Index*>(a_buffer.data() + offset);
+	for (auto& face : a_cdt.finite_face_handles())
+	{
+		*ids++ = static_cast<Index>(face->vertex(0)->info());
+		*ids++ = static_cast<Index>(face->vertex(1)->info());
+		*ids++ = static_cast<Index>(face->vertex(2)->info());
+	}
+} // AppendBinaryMesh
+
+//------------------------------------------------------------------------------
+/// \brief Write a mesh in one of the binary formats with a single write.
+/// \param a_cdt: Mesh to save.
+/// \param a_vertices: Vertices in output order.
+/// \param a_format: OutputFormat::Binary or OutputFormat::Compact.
+/// \param a_quantizationBits: Resolution of compact coordinates.
+/// \param a_out: Stream to write to.
+/// \param a_status: Stream status lines are written to.
+//------------------------------------------------------------------------------
+void WriteBinaryMesh(CDT& a_cdt, const std::vector<CDT::Vertex_handle>& a_vertices,
+	OutputFormat a_format, int a_quantizationBits, std::ostream& a_out, std::ostream& a_status)
+{
+	BinaryResultHeader header;
+	std::memcpy(header.magic, BINARY_RESULT_MAGIC, sizeof(header.magic));
+	header.version = BINARY_RESULT_VERSION;
+	header.flags = 0;
+	header.numPoints = a_vertices.size();
+	header.numTriangles = a_cdt.number_of_faces();
+
+	bool wideIndices = a_vertices.size() > std::numeric_limits<uint32_t>::max();
+	if (a_format == OutputFormat::Compact)
+		header.flags |= RESULT_FLAG_COMPACT;
+	else if (wideIndices)
+		header.flags |= RESULT_FLAG_64BIT_INDICES;
+
+	std::vector<char> buffer;
+	AppendBytes(buffer, &header, sizeof(header));
+	if (a_format == OutputFormat::Compact)
+		AppendCompactMesh(a_cdt, a_vertices, a_quantizationBits, buffer, a_status);
+	else if (wideIndices)
+		AppendBinaryMesh<uint64_t>(a_cdt, a_vertices, buffer, a_status);
+	else
+		AppendBinaryMesh<uint32_t>(a_cdt, a_vertices, buffer, a_status);
+
+	a_out.write(buffer.data(), buffer.size());
+} // WriteBinaryMesh
+
+//------------------------------------------------------------------------------
+/// \brief Save a mesh for XMS.
+/// \param a_cdt: Mesh to save.
+/// \param a_out: Stream to save mesh to.
+/// \param a_format: Layout of the file.
+/// \param a_quantizationBits: Resolution of coordinates in the compact format.
+/// \param a_status: Stream status lines are written to.
+/// \param a_skipSaving: Whether the job was cancelled without saving.
+//------------------------------------------------------------------------------
+void SaveMesh(CDT& a_cdt, std::ostream& a_out, OutputFormat a_format, int a_quantizationBits,
+	std::ostream& a_status, bool a_skipSaving)
+{
+	if (a_skipSaving)
+	{
+		a_status << "status=skip-saving" << std::endl;
+		return;
+	}
+
+	std::vector<CDT::Vertex_handle> vertices = NumberVertices(a_cdt);
+	if (a_format == OutputFormat::Text)
+		WriteTextMesh(a_cdt, vertices, a_out, a_status);
+	else
+		WriteBinaryMesh(a_cdt, vertices, a_format, a_quantizationBits, a_out, a_status);
+	a_out.flush();
+	a_status << "status=done-saving" << std::endl;
+} // SaveMesh
+
+//------------------------------------------------------------------------------
+/// \brief Optimize a mesh.
+/// \param a_cdt: Mesh to optimize.
+/// \param a_parameters: Limits on the optimization.
+/// \param a_updatePolicy: How each iteration applies its moves.
+/// \param a_activeSet: Whether iterations only move the vertices whose
+///                     neighborhood changed in the previous one.
+/// \param a_relaxation: Over-relaxation factor of the moves.
+/// \param a_andersonWindow: Iterations mixed by Anderson acceleration, 0 for none.
+/// \param a_levels: Levels of multilevel optimization, 1 for none.
+/// \param a_smoother: Move computed for each vertex.
+/// \param a_lbfgsMemory: Iterations remembered by L-BFGS, 0 for none.
+/// \param a_stop: Flag that cancels the optimization when set.
+/// \param a_status: Stream status lines are written to.
+/// \return Why the optimization stopped.
+//------------------------------------------------------------------------------
+CGAL::Mesh_optimization_return_code OptimizeMesh(CDT& a_cdt, const JobParameters& a_parameters,
+	CGAL::Mesh_2::Move_update_policy a_updatePolicy, bool a_activeSet, double a_relaxation,
+	int a_andersonWindow, int a_levels, Smoother a_smoother, int a_lbfgsMemory,
+	std::atomic<bool>* a_stop, std::ostream& a_status)
+{
+	if (a_smoother == Smoother::Odt)
+	{
+		return CGAL::odt_optimize_mesh_2(a_cdt,
+			CGAL::parameters::time_limit = a_parameters.timeLimit,
+			CGAL::parameters::max_iteration_number = a_parameters.iterations,
+			CGAL::parameters::convergence = a_parameters.convergenceRatio,
+			CGAL::parameters::freeze_bound = a_parameters.freezeBound,
+			CGAL::parameters::mark = true,
+			CGAL::parameters::pointer_to_stop_atomic_boolean = a_stop,
+			CGAL::parameters::pointer_to_output_stream = &a_status,
+			CGAL::parameters::concurrency_tag = CGAL::Parallel_if_available_tag(),
+			CGAL::parameters::update_policy = a_updatePolicy,
+			CGAL::parameters::active_set = a_activeSet,
+			CGAL::parameters::relaxation = a_relaxation,
+			CGAL::parameters::anderson_window = a_andersonWindow,
+			CGAL::parameters::number_of_levels = a_levels,
+			CGAL::parameters::lbfgs_memory = a_lbfgsMemory);
+	}
+	return CGAL::lloyd_optimize_mesh_2(a_cdt,
+		CGAL::parameters::time_limit = a_parameters.timeLimit,
+		CGAL::parameters::max_iteration_number = a_parameters.iterations,
+		CGAL::parameters::convergence = a_parameters.convergenceRatio,
+		CGAL::parameters::freeze_bound = a_parameters.freezeBound,
+		CGAL::parameters::mark = true,
+		CGAL::parameters::pointer_to_stop_atomic_boolean = a_stop,
+		CGAL::parameters::pointer_to_output_stream = &a_status,
+		CGAL::parameters::concurrency_tag = CGAL::Parallel_if_available_tag(),
+		CGAL::parameters::update_policy = a_updatePolicy,
+		CGAL::parameters::active_set = a_activeSet,
+		CGAL::parameters::relaxation = a_relaxation,
+		CGAL::parameters::anderson_window = a_andersonWindow,
+		CGAL::parameters::number_of_levels = a_levels,
+		CGAL::parameters::lbfgs_memory = a_lbfgsMemory);
+} // OptimizeMesh
 
 //------------------------------------------------------------------------------
-/// \brief Watch for cancel request, then set stopOptimizing to true.
+/// \brief 128-bit hash of a sequence of bytes, for naming cache entries.
+///
+/// Bytes are consumed eight at a time, so adding data in pieces that are
+/// multiples of eight bytes long gives the same hash as adding it at once.
 //------------------------------------------------------------------------------
-void WatchForCancel()
+class Hasher
 {
-	char flag = std::cin.get();
-	stopOptimizing = true;
-	skipSaving = (flag == '1');
-} // WatchForCancel
+public:
+	void Add(const void* a_data, size_t a_size);
+
+	template <typename T>
+	void Add(const T& a_value)
+	{
+		Add(&a_value, sizeof(a_value));
+	}
+
+	std::string Hex() const;
+
+private:
+	void Mix(uint64_t a_word);
+
+	uint64_t m_h1 = 0x9e3779b97f4a7c15ull;
+	uint64_t m_h2 = 0xc2b2ae3d27d4eb4full;
+	uint64_t m_size = 0;
+};
 
 //------------------------------------------------------------------------------
-/// \brief Load a mesh provided by XMS.
-/// \param a_in: Stream to load mesh from.
-/// \param a_cdt: CDT to put mesh into.
+/// \brief Rotate the bits of a 64-bit word left.
+/// \param a_word: The word.
+/// \param a_bits: Number of bits, in (0, 64).
+/// \return The rotated word.
 //------------------------------------------------------------------------------
-void LoadMesh(std::ifstream& a_in, CDT& a_cdt)
+inline uint64_t RotateLeft(uint64_t a_word, int a_bits)
 {
-	std::cout << "status=loading-points" << std::endl;
-	std::vector<CDT::Point_2> points;
-	size_t numPoints = 0;
-	a_in >> numPoints;
-	for (size_t i = 0; i < numPoints; i++)
+	return (a_word << a_bits) | (a_word >> (64 - a_bits));
+} // RotateLeft
+
+//------------------------------------------------------------------------------
+/// \brief Scramble the bits of a 64-bit word. MurmurHash3's finalizer.
+/// \param a_word: The word.
+/// \return The scrambled word.
+//------------------------------------------------------------------------------
+inline uint64_t Scramble(uint64_t a_word)
+{
+	a_word ^= a_word >> 33;
+	a_word *= 0xff51afd7ed558ccdull;
+	a_word ^= a_word >> 33;
+	a_word *= 0xc4ceb9fe1a85ec53ull;
+	a_word ^= a_word >> 33;
+	return a_word;
+} // Scramble
+
+//------------------------------------------------------------------------------
+/// \brief Add bytes to the hash.
+/// \param a_data: The bytes.
+/// \param a_size: Number of bytes.
+//------------------------------------------------------------------------------
+void Hasher::Add(const void* a_data, size_t a_size)
+{
+	const char* data = static_cast<const char*>(a_data);
+	m_size += a_size;
+	for (; a_size >= sizeof(uint64_t); data += sizeof(uint64_t), a_size -= sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, data, sizeof(word));
+		Mix(word);
+	}
+	if (a_size > 0)
+	{
+		uint64_t word = 0;
+		std::memcpy(&word, data, a_size);
+		Mix(word ^ (static_cast<uint64_t>(a_size) << 56));
+	}
+} // Hasher::Add
+
+//------------------------------------------------------------------------------
+/// \brief Mix one word into both halves of the hash.
+/// \param a_word: The word.
+//------------------------------------------------------------------------------
+void Hasher::Mix(uint64_t a_word)
+{
+	m_h1 = RotateLeft(m_h1 ^ (a_word * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+	m_h2 = RotateLeft(m_h2 ^ (a_word * 0x52dce729da3ed7d5ull), 33) * 0x38495ab5c5a4b3d3ull + m_h1;
+} // Hasher::Mix
+
+//------------------------------------------------------------------------------
+/// \brief Get the hash.
+/// \return The hash as 32 hexadecimal digits.
+//------------------------------------------------------------------------------
+std::string Hasher::Hex() const
+{
+	uint64_t halves[2] = { Scramble(m_h1 ^ m_size), Scramble(m_h2 + Scramble(m_h1) + m_size) };
+	std::string hex;
+	for (uint64_t half : halves)
 	{
-		double x, y;
-		a_in >> x >> y;
-		CDT::Point_2 point(x, y);
-		a_cdt.insert(point);
-		points.push_back(point);
+		for (int shift = 60; shift >= 0; shift -= 4)
+		{
+			hex += "0123456789abcdef"[(half >> shift) & 0xf];
+		}
 	}
+	return hex;
+} // Hasher::Hex
+
+/// Changes whenever the output for a given input might, so old entries miss.
+const uint32_t RESULT_CACHE_VERSION = 3;
+
+/// Whether OptimizeMesh runs in parallel. Only the flip pass of batch moves
+/// differs from a sequential build: its centroid sums may start from another
+/// incident face, so the output may differ in the last bits, from one run to
+/// the next as well.
+const bool PARALLEL_OPTIMIZATION =
+	std::is_convertible<CGAL::Parallel_if_available_tag, CGAL::Parallel_tag>::value;
 
-	std::cout << "status=loading-boundaries" << std::endl;
-	size_t numBoundaries = 0;
-	a_in >> numBoundaries;
-	for (size_t i = 0; i < numBoundaries; i++)
+//------------------------------------------------------------------------------
+/// \brief Get the cache key of a job.
+///
+/// Covers the parsed points and constraints rather than the file, so the same
+/// mesh in either input format gives the same key. Indices are hashed as 64-bit
+/// values for the same reason. Batch moves of a parallel build are keyed apart
+/// from those of a sequential build, since a cache directory may be shared by
+/// both.
+///
+/// \param a_input: The job's points and constraints.
+/// \param a_parameters: The job's parameters and output format.
+/// \param a_quantizationBits: Resolution of coordinates in the compact format.
+/// \param a_updatePolicy: How the optimization applies its moves.
+/// \param a_activeSet: Whether the optimization uses an active set.
+/// \param a_relaxation: Over-relaxation factor of the moves.
+/// \param a_andersonWindow: Iterations mixed by Anderson acceleration.
+/// \param a_levels: Levels of multilevel optimization.
+/// \param a_smoother: Move computed for each vertex.
+/// \param a_lbfgsMemory: Iterations remembered by L-BFGS.
+/// \return The key.
+//------------------------------------------------------------------------------
+std::string CacheKey(const MeshInput& a_input, const JobParameters& a_parameters,
+	int a_quantizationBits, CGAL::Mesh_2::Move_update_policy a_updatePolicy, bool a_activeSet,
+	double a_relaxation, int a_andersonWindow, int a_levels, Smoother a_smoother,
+	int a_lbfgsMemory)
+{
+	Hasher hasher;
+	hasher.Add(RESULT_CACHE_VERSION);
+	hasher.Add(static_cast<int32_t>(PARALLEL_OPTIMIZATION
+		&& a_updatePolicy == CGAL::Mesh_2::BATCH_MOVES));
+	hasher.Add(static_cast<int32_t>(a_parameters.iterations));
+	hasher.Add(static_cast<int32_t>(a_parameters.timeLimit));
+	hasher.Add(a_parameters.convergenceRatio);
+	hasher.Add(a_parameters.freezeBound);
+	hasher.Add(static_cast<int32_t>(a_parameters.outputFormat));
+	hasher.Add(static_cast<int32_t>(a_quantizationBits));
+	hasher.Add(static_cast<int32_t>(a_updatePolicy));
+	hasher.Add(static_cast<int32_t>(a_activeSet));
+	hasher.Add(a_relaxation);
+	hasher.Add(static_cast<int32_t>(a_andersonWindow));
+	hasher.Add(static_cast<int32_t>(a_levels));
+	hasher.Add(static_cast<int32_t>(a_smoother));
+	hasher.Add(static_cast<int32_t>(a_lbfgsMemory));
+	hasher.Add(static_cast<uint64_t>(a_input.noCrossings));
+	hasher.Add(static_cast<uint64_t>(a_input.numPoints));
+	hasher.Add(a_input.xy, a_input.numPoints * 2 * sizeof(double));
+	hasher.Add(static_cast<uint64_t>(a_input.numConstraints));
+	if (a_input.wideIndices)
 	{
-		size_t a, b;
-		a_in >> a >> b;
-		a_cdt.insert_constraint(points[a], points[b]);
+		hasher.Add(a_input.constraints, a_input.numConstraints * 2 * sizeof(uint64_t));
 	}
-	std::cout << "status=loaded" << std::endl;
-} // LoadMesh
+	else
+	{
+		const uint32_t* constraints = static_cast<const uint32_t*>(a_input.constraints);
+		std::vector<uint64_t> wide;
+		for (size_t i = 0; i < 2 * a_input.numConstraints; i += wide.size())
+		{
+			wide.assign(constraints + i, constraints + (std::min)(i + 4096, 2 * a_input.numConstraints));
+			hasher.Add(wide.data(), wide.size() * sizeof(uint64_t));
+		}
+	}
+	return hasher.Hex();
+} // CacheKey
 
 //------------------------------------------------------------------------------
-/// \brief Save a mesh for XMS.
-/// \param a_cdt: Mesh to save.
-/// \param a_file: Path to save mesh to.
+/// \brief Directory of to-xms files from earlier runs, named by CacheKey.
+///
+/// When the files add up to more than the size limit, the least recently used
+/// are deleted. A file's modification time records when it was last used, so
+/// several processes can share a directory without any other bookkeeping.
+//------------------------------------------------------------------------------
+class ResultCache
+{
+public:
+	ResultCache(const std::string& a_directory, uintmax_t a_maxSize);
+
+	bool Fetch(const std::string& a_key, std::string& a_contents);
+	void Store(const std::string& a_key, const std::string& a_contents);
+
+private:
+	std::filesystem::path Path(const std::string& a_key) const;
+	void Trim();
+
+	std::filesystem::path m_directory;
+	uintmax_t m_maxSize;
+	std::mutex m_mutex;                ///< Serializes trimming between batch jobs.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Constructor.
+/// \param a_directory: Directory to keep results in. Created when needed.
+/// \param a_maxSize: Limit on the total size of the results, in bytes.
+//------------------------------------------------------------------------------
+ResultCache::ResultCache(const std::string& a_directory, uintmax_t a_maxSize)
+: m_directory(a_directory)
+, m_maxSize(a_maxSize)
+{
+} // ResultCache::ResultCache
+
+//------------------------------------------------------------------------------
+/// \brief Get the path of a result.
+/// \param a_key: The result's key.
+/// \return The path.
+//------------------------------------------------------------------------------
+std::filesystem::path ResultCache::Path(const std::string& a_key) const
+{
+	return m_directory / (a_key + ".xms");
+} // ResultCache::Path
+
+//------------------------------------------------------------------------------
+/// \brief Read a result, marking it as recently used.
+/// \param a_key: The result's key.
+/// \param a_contents: Receives the to-xms contents.
+/// \return Whether the result was found.
+//------------------------------------------------------------------------------
+bool ResultCache::Fetch(const std::string& a_key, std::string& a_contents)
+{
+	std::filesystem::path path = Path(a_key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	if (!file)
+		return false;
+	a_contents = contents.str();
+
+	std::error_code error;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	return true;
+} // ResultCache::Fetch
+
+//------------------------------------------------------------------------------
+/// \brief Add a result, then trim the cache to its size limit.
+///
+/// The result is written under a temporary name and renamed, so readers in
+/// other processes never see part of it.
+///
+/// \param a_key: The result's key.
+/// \param a_contents: The to-xms contents.
 //------------------------------------------------------------------------------
-void SaveMesh(CDT& a_cdt, const std::string& a_file)
+void ResultCache::Store(const std::string& a_key, const std::string& a_contents)
 {
-	std::map<CDT::Point_2, size_t> map;
-	size_t id = 0;
-	std::ofstream out(a_file);
+	if (a_contents.size() > m_maxSize)
+		return;
 
-	if (skipSaving)
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+#ifdef _WIN32
+	unsigned long processId = GetCurrentProcessId();
+#else
+	long processId = getpid();
+#endif
+	std::filesystem::path temporary = m_directory / (a_key + "." + std::to_string(processId) +
+		"." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp");
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		file.write(a_contents.data(), a_contents.size());
+		if (!file.flush())
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, Path(a_key), error);
+	if (error)
 	{
-		std::cout << "status=skip-saving" << std::endl;
+		std::filesystem::remove(temporary, error);
 		return;
 	}
+	Trim();
+} // ResultCache::Store
 
-	std::cout << "status=saving-points" << std::endl;
-	for (auto& vertex : a_cdt.finite_vertex_handles())
+//------------------------------------------------------------------------------
+/// \brief Delete the least recently used results until the rest fit the limit.
+//------------------------------------------------------------------------------
+void ResultCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	struct Entry
+	{
+		std::filesystem::file_time_type time;
+		uintmax_t size;
+		std::filesystem::path path;
+	};
+	std::vector<Entry> entries;
+	uintmax_t total = 0;
+	std::error_code error;
+	for (std::filesystem::directory_iterator it(m_directory, error), end; !error && it != end;
+		it.increment(error))
 	{
-		map[vertex->point()] = id++;
-		out << vertex->point().x() << ' ' << vertex->point().y() << '\n';
+		if (it->path().extension() != ".xms")
+			continue;
+		std::error_code entryError;
+		Entry entry = { it->last_write_time(entryError), it->file_size(entryError), it->path() };
+		if (entryError)
+			continue;
+		total += entry.size;
+		entries.push_back(entry);
 	}
+	if (total <= m_maxSize)
+		return;
 
-	std::cout << "status=saving-edges" << std::endl;
-	out << "-\n";
-	for (auto& face : a_cdt.finite_face_handles())
+	std::sort(entries.begin(), entries.end(),
+		[](const Entry& a, const Entry& b) { return a.time < b.time; });
+	for (const Entry& entry : entries)
 	{
-		size_t a = map[face->vertex(0)->point()];
-		size_t b = map[face->vertex(1)->point()];
-		size_t c = map[face->vertex(2)->point()];
-		out << a << ' ' << b << ' ' << c << '\n';
+		if (total <= m_maxSize)
+			break;
+		if (std::filesystem::remove(entry.path, error))
+			total -= entry.size;
 	}
-	std::cout << "status=done-saving" << std::endl;
-} // SaveMesh
+} // ResultCache::Trim
+
+//------------------------------------------------------------------------------
+/// \brief Mesh, optimize and save a loaded job, or copy its result from the cache.
+///
+/// Results are only cached when they don't depend on how fast the machine is:
+/// runs that were cancelled or hit their time limit aren't stored.
+///
+/// \param a_input: The job's points and constraints.
+/// \param a_parameters: The job's parameters and output format.
+/// \param a_options: Command line options.
+/// \param a_cache: Cache of earlier results, or null.
+/// \param a_stop: Flag that cancels the optimization when set.
+/// \param a_skipSaving: Flag that skips saving when set.
+/// \param a_output: Path to save the mesh to, or "-" for a_stdout.
+/// \param a_stdout: Stream to save the mesh to when a_output is "-".
+/// \param a_status: Stream status lines are written to.
+/// \return Whether every constraint referred to a valid point.
+//------------------------------------------------------------------------------
+bool ProcessJob(const MeshInput& a_input, const JobParameters& a_parameters,
+	const ProgramOptions& a_options, ResultCache* a_cache, std::atomic<bool>* a_stop,
+	const std::atomic<bool>& a_skipSaving, const std::string& a_output, std::ostream& a_stdout,
+	std::ostream& a_status)
+{
+	std::ofstream file;
+	auto openOutput = [&]() -> std::ostream& {
+		if (a_output == "-")
+			return a_stdout;
+		file.open(a_output, a_parameters.outputFormat == OutputFormat::Text ? std::ios::out :
+			std::ios::out | std::ios::binary);
+		return file;
+	};
+
+	std::string key;
+	if (a_cache)
+	{
+		key = CacheKey(a_input, a_parameters, a_options.quantizationBits, a_options.updatePolicy,
+			a_options.activeSet, a_options.relaxation, a_options.andersonWindow, a_options.levels,
+			a_options.smoother, a_options.lbfgsMemory);
+		std::string cached;
+		if (a_cache->Fetch(key, cached))
+		{
+			a_status << "status=cache-hit" << std::endl;
+			if (a_skipSaving)
+			{
+				a_status << "status=skip-saving" << std::endl;
+				return true;
+			}
+			std::ostream& out = openOutput();
+			out.write(cached.data(), cached.size());
+			out.flush();
+			a_status << "status=done-saving" << std::endl;
+			return true;
+		}
+		a_status << "status=cache-miss" << std::endl;
+	}
+
+	CDT cdt;
+	if (!BuildMesh(a_input, cdt, a_status))
+		return false;
+	CGAL::Mesh_optimization_return_code result = OptimizeMesh(cdt, a_parameters, a_options.updatePolicy,
+		a_options.activeSet, a_options.relaxation, a_options.andersonWindow, a_options.levels,
+		a_options.smoother, a_options.lbfgsMemory, a_stop, a_status);
+
+	std::ostream& out = openOutput();
+	if (!a_cache || *a_stop || result == CGAL::TIME_LIMIT_REACHED)
+	{
+		SaveMesh(cdt, out, a_parameters.outputFormat, a_options.quantizationBits, a_status,
+			a_skipSaving);
+		return true;
+	}
+
+	std::string copy;
+	TeeStreambuf tee(out.rdbuf(), copy);
+	std::ostream teeOut(&tee);
+	SaveMesh(cdt, teeOut, a_parameters.outputFormat, a_options.quantizationBits, a_status,
+		a_skipSaving);
+	if (!a_skipSaving && out)
+		a_cache->Store(key, copy);
+	return true;
+} // ProcessJob
+
+//------------------------------------------------------------------------------
+/// \brief Parse the name of an output format.
+/// \param a_name: "text", "binary" or "compact".
+/// \param a_format: Receives the format.
+/// \return Whether the name was valid.
+//------------------------------------------------------------------------------
+bool ParseOutputFormat(const std::string& a_name, OutputFormat& a_format)
+{
+	if (a_name == "text")
+		a_format = OutputFormat::Text;
+	else if (a_name == "binary")
+		a_format = OutputFormat::Binary;
+	else if (a_name == "compact")
+		a_format = OutputFormat::Compact;
+	else
+		return false;
+	return true;
+} // ParseOutputFormat
+
+//------------------------------------------------------------------------------
+/// \brief Parse the name of a smoother.
+/// \param a_name: "lloyd" or "odt".
+/// \param a_smoother: Receives the smoother.
+/// \return Whether the name was valid.
+//------------------------------------------------------------------------------
+bool ParseSmoother(const std::string& a_name, Smoother& a_smoother)
+{
+	if (a_name == "lloyd")
+		a_smoother = Smoother::Lloyd;
+	else if (a_name == "odt")
+		a_smoother = Smoother::Odt;
+	else
+		return false;
+	return true;
+} // ParseSmoother
+
+//------------------------------------------------------------------------------
+/// \brief Get the path of a file in a job directory.
+/// \param a_directory: The job directory.
+/// \param a_name: Name of the file, e.g. "to-cgal".
+/// \return The path.
+//------------------------------------------------------------------------------
+std::string JobFile(std::string a_directory, const char* a_name)
+{
+#ifdef _WIN32
+	const char separator = '\\';
+#else
+	const char separator = '/';
+#endif
+	if (a_directory.back() != '/' && a_directory.back() != '\\')
+		a_directory += separator;
+	return a_directory + a_name;
+} // JobFile
+
+//------------------------------------------------------------------------------
+/// \brief A request read in server mode.
+///
+/// Requests are single lines of ';' separated fields, the same framing as the
+/// status lines:
+/// - run;id=<id>;dir=<path>[;input=<path>][;output=<path>][;inline=<bytes>]
+///   [;iterations=<n>][;time=<seconds>][;convergence=<ratio>][;freeze=<bound>]
+///   [;format=text|binary|compact]
+/// - cancel;id=<id>[;skip=1]
+/// - quit
+///
+/// inline=<bytes> is followed by that many bytes of to-cgal data straight after
+/// the newline. The other optional fields override the job's header.
+//------------------------------------------------------------------------------
+struct ServerRequest
+{
+	std::string command;
+	std::string id;
+	std::string input;                 ///< to-cgal path. Unused with an inline payload.
+	std::string output;                ///< to-xms path, or empty to send it back inline.
+	bool hasPayload = false;
+	size_t payloadSize = 0;
+	std::vector<double> payload;       ///< Inline to-cgal data, kept 8-byte aligned.
+	std::optional<int> iterations;
+	std::optional<int> timeLimit;
+	std::optional<double> convergenceRatio;
+	std::optional<double> freezeBound;
+	std::optional<OutputFormat> outputFormat;
+	bool valid = true;                 ///< Whether every field parsed.
+	bool cancelled = false;            ///< Cancelled before it started.
+	bool skipSaving = false;           ///< Don't save when cancelled.
+};
+
+//------------------------------------------------------------------------------
+/// \brief Parse the value of a numeric request field.
+/// \param a_value: The field's value.
+/// \param a_result: Receives the number.
+/// \return Whether the whole value was a number.
+//------------------------------------------------------------------------------
+template <typename T>
+bool ParseField(const std::string& a_value, T& a_result)
+{
+	const char* cursor = a_value.data();
+	const char* end = cursor + a_value.size();
+	return ParseToken(cursor, end, a_result) && cursor == end;
+} // ParseField
+
+//------------------------------------------------------------------------------
+/// \brief Parse a request line.
+///
+/// Parsing carries on past bad fields so an inline payload is still known
+/// about and can be skipped.
+///
+/// \param a_line: The line, without its newline.
+/// \param a_request: Receives the request. valid is cleared on errors.
+//------------------------------------------------------------------------------
+void ParseRequest(const std::string& a_line, ServerRequest& a_request)
+{
+	size_t begin = 0;
+	while (begin <= a_line.size())
+	{
+		size_t end = a_line.find(';', begin);
+		if (end == std::string::npos)
+			end = a_line.size();
+		std::string field = a_line.substr(begin, end - begin);
+		begin = end + 1;
+
+		size_t equals = field.find('=');
+		if (a_request.command.empty())
+		{
+			a_request.command = field;
+			continue;
+		}
+		if (field.empty())
+			continue;
+		if (equals == std::string::npos)
+		{
+			a_request.valid = false;
+			continue;
+		}
+		std::string key = field.substr(0, equals);
+		std::string value = field.substr(equals + 1);
+		bool ok = true;
+		if (key == "id")
+			a_request.id = value;
+		else if (key == "dir" && !value.empty())
+		{
+			if (a_request.input.empty())
+				a_request.input = JobFile(value, "to-cgal");
+			if (a_request.output.empty())
+				a_request.output = JobFile(value, "to-xms");
+		}
+		else if (key == "input")
+			a_request.input = value;
+		else if (key == "output")
+			a_request.output = value;
+		else if (key == "inline")
+			ok = a_request.hasPayload = ParseField(value, a_request.payloadSize);
+		else if (key == "iterations")
+			ok = ParseField(value, a_request.iterations.emplace());
+		else if (key == "time")
+			ok = ParseField(value, a_request.timeLimit.emplace());
+		else if (key == "convergence")
+			ok = ParseField(value, a_request.convergenceRatio.emplace());
+		else if (key == "freeze")
+			ok = ParseField(value, a_request.freezeBound.emplace());
+		else if (key == "format")
+			ok = ParseOutputFormat(value, a_request.outputFormat.emplace());
+		else if (key == "skip")
+			a_request.skipSaving = (value == "1");
+		else
+			ok = false;
+		a_request.valid = a_request.valid && ok;
+	}
+	if (a_request.command == "run")
+	{
+		a_request.valid = a_request.valid && !a_request.id.empty() &&
+			(a_request.hasPayload || !a_request.input.empty());
+	}
+	else if (a_request.command == "cancel")
+	{
+		a_request.valid = a_request.valid && !a_request.id.empty();
+	}
+} // ParseRequest
+
+//------------------------------------------------------------------------------
+/// \brief Queue of jobs waiting to run in server mode.
+///
+/// The request reader fills it and the main thread runs the jobs in order.
+/// Cancel requests are applied here so they can't race with a job starting.
+//------------------------------------------------------------------------------
+class JobQueue
+{
+public:
+	void Push(std::unique_ptr<ServerRequest> a_request);
+	std::unique_ptr<ServerRequest> Pop();
+	void Finish();
+	void Cancel(const std::string& a_id, bool a_skipSaving);
+	void Close();
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_ready;
+	std::deque<std::unique_ptr<ServerRequest>> m_jobs;
+	std::string m_current;             ///< ID of the running job.
+	bool m_running = false;
+	bool m_closed = false;
+};
+
+//------------------------------------------------------------------------------
+/// \brief Add a job to the end of the queue.
+/// \param a_request: The job.
+//------------------------------------------------------------------------------
+void JobQueue::Push(std::unique_ptr<ServerRequest> a_request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(a_request));
+	}
+	m_ready.notify_one();
+} // JobQueue::Push
+
+//------------------------------------------------------------------------------
+/// \brief Wait for the next job and mark it as running.
+///
+/// Resets stopOptimizing and skipSaving for the job, to set if it was
+/// cancelled while queued.
+///
+/// \return The job, or null once the queue is closed and empty.
+//------------------------------------------------------------------------------
+std::unique_ptr<ServerRequest> JobQueue::Pop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_ready.wait(lock, [this] { return m_closed || !m_jobs.empty(); });
+	if (m_jobs.empty())
+		return nullptr;
+	std::unique_ptr<ServerRequest> request = std::move(m_jobs.front());
+	m_jobs.pop_front();
+	m_current = request->id;
+	m_running = true;
+	skipSaving = request->cancelled && request->skipSaving;
+	stopOptimizing = request->cancelled;
+	return request;
+} // JobQueue::Pop
+
+//------------------------------------------------------------------------------
+/// \brief Mark the running job as done, so later cancels for it are ignored.
+//------------------------------------------------------------------------------
+void JobQueue::Finish()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_running = false;
+} // JobQueue::Finish
+
+//------------------------------------------------------------------------------
+/// \brief Cancel a running or queued job.
+/// \param a_id: ID of the job.
+/// \param a_skipSaving: Whether to skip saving the mesh.
+//------------------------------------------------------------------------------
+void JobQueue::Cancel(const std::string& a_id, bool a_skipSaving)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_running && m_current == a_id)
+	{
+		skipSaving = a_skipSaving;
+		stopOptimizing = true;
+	}
+	for (std::unique_ptr<ServerRequest>& request : m_jobs)
+	{
+		if (request->id == a_id)
+		{
+			request->cancelled = true;
+			request->skipSaving = a_skipSaving;
+		}
+	}
+} // JobQueue::Cancel
+
+//------------------------------------------------------------------------------
+/// \brief Stop accepting jobs. Pop returns null once the queue empties.
+//------------------------------------------------------------------------------
+void JobQueue::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_ready.notify_all();
+} // JobQueue::Close
+
+//------------------------------------------------------------------------------
+/// \brief Read requests until quit or end of input, queueing the jobs.
+/// \param a_in: Stream the requests arrive on.
+/// \param a_queue: Queue to put jobs in.
+//------------------------------------------------------------------------------
+void ReadRequests(std::istream* a_in, JobQueue* a_queue)
+{
+	std::string line;
+	while (std::getline(*a_in, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+
+		std::unique_ptr<ServerRequest> request(new ServerRequest);
+		ParseRequest(line, *request);
+		if (request->hasPayload)
+		{
+			request->payload.resize((request->payloadSize + sizeof(double) - 1) / sizeof(double));
+			if (!a_in->read(reinterpret_cast<char*>(request->payload.data()),
+				request->payloadSize))
+				break;
+		}
+
+		if (request->command == "quit")
+			break;
+		else if (request->command == "cancel" && request->valid)
+			a_queue->Cancel(request->id, request->skipSaving);
+		else
+			a_queue->Push(std::move(request));
+	}
+	a_queue->Close();
+} // ReadRequests
+
+//------------------------------------------------------------------------------
+/// \brief Run one server mode job.
+///
+/// Status lines are expected to be tagged with the job ID by the caller. A mesh
+/// without an output path is sent after status=done-saving as a
+/// "job=<id>;mesh=<bytes>" line on a_meshOut followed by the data.
+///
+/// \param a_request: The job.
+/// \param a_options: Command line options.
+/// \param a_cache: Cache of earlier results, or null.
+/// \param a_meshOut: Stream inline meshes are written to.
+//------------------------------------------------------------------------------
+void RunServerJob(ServerRequest& a_request, const ProgramOptions& a_options,
+	ResultCache* a_cache, std::ostream& a_meshOut)
+{
+	if (!a_request.valid || a_request.command != "run")
+	{
+		std::cout << "status=invalid-request" << std::endl;
+		return;
+	}
+
+	JobParameters parameters;
+	MeshInput input;
+	bool loaded = a_request.hasPayload ?
+		LoadMesh(reinterpret_cast<const char*>(a_request.payload.data()), a_request.payloadSize,
+			parameters, input) :
+		LoadInput(a_request.input, parameters, input);
+	if (!loaded)
+	{
+		std::cout << "status=failed" << std::endl;
+		return;
+	}
+
+	parameters.iterations = a_request.iterations.value_or(parameters.iterations);
+	parameters.timeLimit = a_request.timeLimit.value_or(parameters.timeLimit);
+	parameters.convergenceRatio = a_request.convergenceRatio.value_or(parameters.convergenceRatio);
+	parameters.freezeBound = a_request.freezeBound.value_or(parameters.freezeBound);
+	if (a_options.outputFormatSet)
+		parameters.outputFormat = a_options.outputFormat;
+	parameters.outputFormat = a_request.outputFormat.value_or(parameters.outputFormat);
+
+	std::ostringstream buffer;
+	if (!ProcessJob(input, parameters, a_options, a_cache, &stopOptimizing, skipSaving,
+		a_request.output.empty() ? "-" : a_request.output, buffer, std::cout))
+	{
+		std::cout << "status=failed" << std::endl;
+		return;
+	}
+	if (a_request.output.empty() && !skipSaving)
+	{
+		std::string mesh = buffer.str();
+		a_meshOut << "job=" << a_request.id << ";mesh=" << mesh.size() << '\n';
+		a_meshOut.write(mesh.data(), mesh.size());
+		a_meshOut.flush();
+	}
+} // RunServerJob
+
+//------------------------------------------------------------------------------
+/// \brief Run jobs as they are requested until told to quit.
+///
+/// Everything that outlives a job, like the worker pool's threads and the
+/// allocator's free lists, stays warm between jobs. Each job's status lines are
+/// prefixed with "job=<id>;".
+///
+/// \param a_options: Command line options.
+/// \param a_cache: Cache of earlier results, or null.
+/// \param a_requests: Stream the requests arrive on.
+/// \param a_meshOut: Stream inline meshes are written to.
+/// \return The program's exit code.
+//------------------------------------------------------------------------------
+int RunServer(const ProgramOptions& a_options, ResultCache* a_cache, std::istream* a_requests,
+	std::ostream& a_meshOut)
+{
+	JobQueue queue;
+	std::thread reader(ReadRequests, a_requests, &queue);
+	std::streambuf* status = std::cout.rdbuf();
+	while (std::unique_ptr<ServerRequest> request = queue.Pop())
+	{
+		PrefixStreambuf tagged(status, "job=" + request->id + ";");
+		std::cout.rdbuf(&tagged);
+		RunServerJob(*request, a_options, a_cache, a_meshOut);
+		std::cout.flush();
+		std::cout.rdbuf(status);
+		queue.Finish();
+	}
+	reader.join();
+	return EXIT_SUCCESS;
+} // RunServer
+
+//------------------------------------------------------------------------------
+/// \brief A job directory run in batch mode.
+//------------------------------------------------------------------------------
+struct BatchJob
+{
+	std::string directory;
+	uintmax_t size = 0;                ///< Size of to-cgal, used to run big jobs first.
+	std::atomic<bool> stop{ false };
+	std::atomic<bool> skipSaving{ false };
+	bool succeeded = false;
+	size_t numPoints = 0;
+};
+
+typedef std::vector<std::unique_ptr<BatchJob>> BatchJobs;
+
+//------------------------------------------------------------------------------
+/// \brief Watch for cancel requests for batch jobs.
+///
+/// Requests are "cancel;id=<directory>[;skip=1]" lines, as in server mode.
+///
+/// \param a_in: Stream the requests arrive on.
+/// \param a_jobs: The jobs. Shared because this thread is never joined.
+//------------------------------------------------------------------------------
+void WatchForBatchCancels(std::istream* a_in, std::shared_ptr<BatchJobs> a_jobs)
+{
+	std::string line;
+	while (std::getline(*a_in, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		ServerRequest request;
+		ParseRequest(line, request);
+		if (request.command != "cancel" || !request.valid)
+		{
+			std::cerr << "Invalid request: " << line << '\n';
+			continue;
+		}
+		for (std::unique_ptr<BatchJob>& job : *a_jobs)
+		{
+			if (job->directory == request.id)
+			{
+				job->skipSaving = request.skipSaving;
+				job->stop = true;
+			}
+		}
+	}
+} // WatchForBatchCancels
+
+//------------------------------------------------------------------------------
+/// \brief Run one batch job.
+/// \param a_job: The job.
+/// \param a_options: Command line options.
+/// \param a_cache: Cache of earlier results, or null.
+/// \param a_status: Stream buffer status lines are written to.
+/// \param a_statusLock: Lock shared by all jobs writing to a_status.
+//------------------------------------------------------------------------------
+void RunBatchJob(BatchJob& a_job, const ProgramOptions& a_options, ResultCache* a_cache,
+	std::streambuf* a_status, std::mutex& a_statusLock)
+{
+	PrefixStreambuf tagged(a_status, "job=" + a_job.directory + ";", &a_statusLock);
+	std::ostream status(&tagged);
+
+	JobParameters parameters;
+	MeshInput input;
+	bool loaded = LoadInput(JobFile(a_job.directory, "to-cgal"), parameters, input);
+	if (a_options.outputFormatSet)
+		parameters.outputFormat = a_options.outputFormat;
+	if (!loaded || !ProcessJob(input, parameters, a_options, a_cache, &a_job.stop,
+		a_job.skipSaving, JobFile(a_job.directory, "to-xms"), std::cout, status))
+	{
+		status << "status=failed" << std::endl;
+		return;
+	}
+	a_job.numPoints = input.numPoints;
+	a_job.succeeded = true;
+} // RunBatchJob
+
+//------------------------------------------------------------------------------
+/// \brief Run a list of job directories concurrently.
+///
+/// Each thread takes the biggest job that hasn't started, so big jobs don't
+/// start last and leave the other threads idle. Every job has its own cancel
+/// flag, and its status lines are prefixed with "job=<directory>;". A summary
+/// line ends the run.
+///
+/// \param a_options: Command line options.
+/// \param a_cache: Cache of earlier results, or null.
+/// \param a_cancelIn: Stream cancel requests arrive on, or null.
+/// \return The program's exit code.
+//------------------------------------------------------------------------------
+int RunBatch(const ProgramOptions& a_options, ResultCache* a_cache, std::istream* a_cancelIn)
+{
+	std::vector<std::string> directories = a_options.batchDirectories;
+	if (!a_options.manifest.empty())
+	{
+		std::ifstream manifest(a_options.manifest);
+		if (!manifest)
+		{
+			std::cerr << "Unable to read: " << a_options.manifest << '\n';
+			return 1;
+		}
+		std::string line;
+		while (std::getline(manifest, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (!line.empty() && line[0] != '#')
+				directories.push_back(line);
+		}
+	}
+
+	std::shared_ptr<BatchJobs> jobs = std::make_shared<BatchJobs>();
+	for (const std::string& directory : directories)
+	{
+		std::unique_ptr<BatchJob> job(new BatchJob);
+		job->directory = directory;
+		std::error_code error;
+		job->size = std::filesystem::file_size(JobFile(directory, "to-cgal"), error);
+		if (error)
+			job->size = 0;
+		jobs->push_back(std::move(job));
+	}
+	std::stable_sort(jobs->begin(), jobs->end(),
+		[](const std::unique_ptr<BatchJob>& a, const std::unique_ptr<BatchJob>& b) {
+			return a->size > b->size;
+		});
+
+	if (a_cancelIn)
+		std::thread(WatchForBatchCancels, a_cancelIn, jobs).detach();
+
+	size_t numThreads = a_options.batchThreads > 0 ? a_options.batchThreads :
+		(std::max)(1u, std::thread::hardware_concurrency());
+	numThreads = (std::min)(numThreads, jobs->size());
+	std::streambuf* status = std::cout.rdbuf();
+	std::mutex statusLock;
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < jobs->size(); i = next++)
+			RunBatchJob(*(*jobs)[i], a_options, a_cache, status, statusLock);
+	};
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; i++)
+		threads.emplace_back(work);
+	work();
+	for (std::thread& thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	size_t numFailed = 0, numPoints = 0;
+	for (std::unique_ptr<BatchJob>& job : *jobs)
+	{
+		numFailed += !job->succeeded;
+		numPoints += job->numPoints;
+	}
+	std::cout << "status=batch-done;"
+		<< "jobs=" << jobs->size() << ";"
+		<< "failed=" << numFailed << ";"
+		<< "points=" << numPoints << ";"
+		<< "time=" << seconds << ";"
+		<< "jobrate=" << (seconds > 0 ? jobs->size() / seconds : 0) << ";"
+		<< "pointrate=" << (seconds > 0 ? numPoints / seconds : 0) << std::endl;
+	return numFailed == 0 ? EXIT_SUCCESS : 1;
+} // RunBatch
+
+//------------------------------------------------------------------------------
+/// \brief Parse the command line.
+/// \param argc: Number of command line arguments.
+/// \param argv: Command line arguments.
+/// \param a_options: Receives the options.
+/// \return Whether the command line was valid.
+//------------------------------------------------------------------------------
+bool ParseOptions(int argc, char* argv[], ProgramOptions& a_options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--output-format" && i + 1 < argc)
+		{
+			a_options.outputFormatSet = true;
+			if (!ParseOutputFormat(argv[++i], a_options.outputFormat))
+				return false;
+		}
+		else if (argument == "--quantization-bits" && i + 1 < argc)
+		{
+			a_options.quantizationBits = std::atoi(argv[++i]);
+			if (a_options.quantizationBits < 1 || a_options.quantizationBits > 52)
+				return false;
+		}
+		else if (argument == "--input" && i + 1 < argc)
+		{
+			a_options.input = argv[++i];
+		}
+		else if (argument == "--output" && i + 1 < argc)
+		{
+			a_options.output = argv[++i];
+		}
+		else if (argument == "--control-fd" && i + 1 < argc)
+		{
+			// Either one descriptor for both directions, like a socket, or "in,out".
+			std::string fds = argv[++i];
+			size_t comma = fds.find(',');
+			a_options.controlIn = std::atoi(fds.substr(0, comma).c_str());
+			a_options.controlOut = comma == std::string::npos ? a_options.controlIn :
+				std::atoi(fds.substr(comma + 1).c_str());
+			if (a_options.controlIn < 0 || a_options.controlOut < 0)
+				return false;
+		}
+		else if (argument == "--server")
+		{
+			a_options.server = true;
+		}
+		else if (argument == "--batch")
+		{
+			a_options.batch = true;
+		}
+		else if (argument == "--manifest" && i + 1 < argc)
+		{
+			a_options.batch = true;
+			a_options.manifest = argv[++i];
+		}
+		else if (argument == "--cache-dir" && i + 1 < argc)
+		{
+			a_options.cacheDirectory = argv[++i];
+		}
+		else if (argument == "--cache-size" && i + 1 < argc)
+		{
+			long long megabytes = std::atoll(argv[++i]);
+			if (megabytes < 1)
+				return false;
+			a_options.cacheSize = static_cast<uintmax_t>(megabytes) << 20;
+		}
+		else if (argument == "--batch-moves")
+		{
+			if (a_options.updatePolicy == CGAL::Mesh_2::GAUSS_SEIDEL_MOVES)
+				return false;
+			a_options.updatePolicy = CGAL::Mesh_2::BATCH_MOVES;
+		}
+		else if (argument == "--gauss-seidel")
+		{
+			if (a_options.updatePolicy == CGAL::Mesh_2::BATCH_MOVES)
+				return false;
+			a_options.updatePolicy = CGAL::Mesh_2::GAUSS_SEIDEL_MOVES;
+		}
+		else if (argument == "--active-set")
+		{
+			a_options.activeSet = true;
+		}
+		else if (argument == "--relaxation" && i + 1 < argc)
+		{
+			a_options.relaxation = std::atof(argv[++i]);
+			if (!(a_options.relaxation > 0))
+				return false;
+		}
+		else if (argument == "--anderson" && i + 1 < argc)
+		{
+			a_options.andersonWindow = std::atoi(argv[++i]);
+			if (a_options.andersonWindow < 0)
+				return false;
+		}
+		else if (argument == "--levels" && i + 1 < argc)
+		{
+			a_options.levels = std::atoi(argv[++i]);
+			if (a_options.levels < 1)
+				return false;
+		}
+		else if (argument == "--lbfgs" && i + 1 < argc)
+		{
+			a_options.lbfgsMemory = std::atoi(argv[++i]);
+			if (a_options.lbfgsMemory < 0)
+				return false;
+		}
+		else if (argument == "--smoother" && i + 1 < argc)
+		{
+			if (!ParseSmoother(argv[++i], a_options.smoother))
+				return false;
+		}
+		else if (argument == "--jobs" && i + 1 < argc)
+		{
+			int jobs = std::atoi(argv[++i]);
+			if (jobs < 1)
+				return false;
+			a_options.batchThreads = jobs;
+		}
+		else if (argument.compare(0, 2, "--") == 0)
+		{
+			return false;
+		}
+		else if (a_options.batch)
+		{
+			a_options.batchDirectories.push_back(argument);
+		}
+		else if (!a_options.directory.empty())
+		{
+			return false;
+		}
+		else
+		{
+			a_options.directory = argument;
+		}
+	}
+	// Without Anderson acceleration, every vertex keeps its plain move from a factor
+	// of 2 on, so such a factor would silently run plain Lloyd.
+	if (a_options.andersonWindow == 0 && !(a_options.relaxation < 2))
+		return false;
+	if (a_options.server || a_options.batch)
+	{
+		return !(a_options.server && a_options.batch) && a_options.directory.empty() &&
+			a_options.input.empty() && a_options.output.empty() &&
+			(!a_options.batch || !a_options.batchDirectories.empty() || !a_options.manifest.empty());
+	}
+	if (!a_options.directory.empty())
+	{
+		if (a_options.input.empty())
+			a_options.input = JobFile(a_options.directory, "to-cgal");
+		if (a_options.output.empty())
+			a_options.output = JobFile(a_options.directory, "to-xms");
+	}
+	return !a_options.input.empty() && !a_options.output.empty();
+} // ParseOptions
 
 //------------------------------------------------------------------------------
 /// \brief Main program function.
-/// \param argc: Number of command line arguments. Should be 2.
-/// \param argv: Command line arguments. Should be program name and path to
-///              working directory.
+/// \param argc: Number of command line arguments.
+/// \param argv: Command line arguments. Should be program name, options and
+///              path to working directory.
 //------------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
+	ProgramOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [options] [--input path|-] [--output path|-]"
+			" [directory]\n"
+			"       " << argv[0] << " --server [options]\n"
+			"       " << argv[0] << " --batch [--jobs count] [--manifest file] [options]"
+			" [directory...]\n"
+			"Options: [--output-format text|binary|compact] [--quantization-bits bits]"
+			" [--control-fd fd|in,out] [--cache-dir directory] [--cache-size megabytes]"
+			" [--batch-moves|--gauss-seidel] [--active-set] [--relaxation factor]"
+			" [--anderson window] [--levels count] [--smoother lloyd|odt]"
+			" [--lbfgs memory]\n";
+		return 1;
+	}
+
+	// Status lines and the cancel byte normally share stdin and stdout with XMS.
+	// When the mesh itself travels over one of those, they move to the control
+	// descriptor, or to stderr (with no way to cancel) if there isn't one.
+	std::ostream meshOut(std::cout.rdbuf());
+	std::unique_ptr<FdStreambuf> controlOut;
+	if (options.controlOut >= 0)
+		controlOut.reset(new FdStreambuf(options.controlOut));
+	else if (options.output == "-")
+		meshOut.rdbuf(std::cout.rdbuf(std::cerr.rdbuf()));
+	if (controlOut)
+		std::cout.rdbuf(controlOut.get());
+	struct RestoreStatus
+	{
+		std::streambuf* buffer;
+		~RestoreStatus() { std::cout.rdbuf(buffer); }
+	} restoreStatus = { meshOut.rdbuf() };
+
+	// The watcher thread is never joined, so its stream is never freed. In server
+	// and batch mode the same stream carries the requests instead.
+	std::istream* cancelIn = nullptr;
+	if (options.controlIn >= 0)
+		cancelIn = new std::istream(new FdStreambuf(options.controlIn));
+	else if (options.input != "-")
+		cancelIn = &std::cin;
+
 	std::cout <<
 		"This program is licensed under the GNU GPL version 3.0 or later.\n"
 		"A copy of this license should be included in the executable's directory "
@@ -114,53 +2679,45 @@ int main(int argc, char* argv[])
 		"Full source code for this program may be obtained from\n"
 		"https://github.com/Aquaveo/cgal-lloyd-optimizer-executable \n\n";
 
-	if (argc != 2)
-	{
-		std::cerr << "Usage: " << argv[0] << " filename\n";
-		return 1;
-	}
+	std::unique_ptr<ResultCache> cache;
+	if (!options.cacheDirectory.empty())
+		cache.reset(new ResultCache(options.cacheDirectory, options.cacheSize));
 
-	std::string directory = argv[1];
-	if (directory[directory.length() - 1] != '/' && directory[directory.length() - 1] != '\\')
+	if (options.server)
 	{
-		directory += '\\';
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		return RunServer(options, cache.get(), cancelIn, meshOut);
 	}
+	if (options.batch)
+		return RunBatch(options, cache.get(), cancelIn);
 
-	std::string inFile = directory + "to-cgal", outFile = directory + "to-xms";
-
-	int iterations = 0;
-	double convergenceRatio = 0;
-	double freezeBound = 0;
-	int timeLimit = 0;
-	CDT cdt;
-
-	std::ifstream in(inFile);
-	if (!in.is_open())
-	{
-		std::cerr << "Unable to open file: " << inFile << '\n';
+	JobParameters parameters;
+	MeshInput input;
+	if (!LoadInput(options.input, parameters, input))
 		return 1;
-	}
-
-	in >> iterations >> timeLimit >> convergenceRatio >> freezeBound;
-	
-	LoadMesh(in, cdt);
+	if (options.outputFormatSet)
+		parameters.outputFormat = options.outputFormat;
+#ifdef _WIN32
+	if (options.output == "-" && parameters.outputFormat != OutputFormat::Text)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
 
-	std::thread watcher(WatchForCancel);
+	std::thread watcher;
+	if (cancelIn)
+		watcher = std::thread(WatchForCancel, cancelIn);
 
-	CGAL::lloyd_optimize_mesh_2(cdt,
-		CGAL::parameters::time_limit = timeLimit,
-		CGAL::parameters::max_iteration_number = iterations,
-		CGAL::parameters::convergence = convergenceRatio,
-		CGAL::parameters::freeze_bound = freezeBound,
-		CGAL::parameters::mark = true);
-
-	SaveMesh(cdt, outFile);
+	bool processed = ProcessJob(input, parameters, options, cache.get(), &stopOptimizing,
+		skipSaving, options.output, meshOut, std::cout);
 
 	// Threads normally raise exceptions if you abandon them, but the thread
 	// doesn't produce any data and we're about to exit anyway. There also isn't
 	// any good way to tell it to stop, so just silence it and let the operating
 	// system clean it up.
-	watcher.detach();
+	if (watcher.joinable())
+		watcher.detach();
 
-	return EXIT_SUCCESS;
+	return processed ? EXIT_SUCCESS : 1;
 } // main
@@ -19,6 +19,14 @@
 #include <CGAL/triangulation_assertions.h>
 #include <CGAL/Constrained_triangulation_2.h>
 #include <CGAL/Triangulation_2/insert_constraints.h>
+#include <CGAL/tags.h>
+
+#ifdef CGAL_LINKED_WITH_TBB
+#include <CGAL/Triangulation_2/internal/Parallel_flips_2.h>
+#endif
+
+#include <algorithm>
+#include <deque>
 
 #ifndef CGAL_TRIANGULATION_2_DONT_INSERT_RANGE_OF_POINTS_WITH_INFO
 #include <CGAL/Spatial_sort_traits_adapter_2.h>
@@ -109,6 +117,7 @@ public:
   typedef typename Ctr::Finite_faces_iterator Finite_faces_iterator;
   typedef typename Ctr::Constrained_edges_iterator Constrained_edges_iterator;
   typedef typename Ctr::Face_circulator       Face_circulator;
+  typedef typename Ctr::Vertex_circulator     Vertex_circulator;
   typedef typename Ctr::size_type             size_type;
   typedef typename Ctr::Locate_type           Locate_type;
 
@@ -244,6 +253,13 @@ public:
 //  OutputItFaces
 //  remove_constrained_edge(Face_handle f, int i, OutputItFaces out)
 
+  // DISPLACEMENT
+  Vertex_handle move_if_no_collision(Vertex_handle v, const Point& p);
+  template <class OutputItFaces>
+  Vertex_handle move_if_no_collision_and_give_new_faces(Vertex_handle v,
+                                                        const Point& p,
+                                                        OutputItFaces oif);
+
   //for backward compatibility
   void insert(Point a, Point b) { insert_constraint(a, b);}
 
@@ -569,6 +585,111 @@ public:
 
 
 public:
+ template <class VertexIterator>
+ size_type
+ restore_Delaunay(VertexIterator first, VertexIterator last,
+                  Sequential_tag = Sequential_tag()) {
+  // restores the constrained Delaunay property with flips after the
+  // points of the vertices in [first, last) were changed in place
+  // and returns the number of flips
+  // Precondition : the incident faces of these vertices are still
+  // counterclockwise oriented
+  Emptyset_iterator out;
+  return restore_Delaunay_impl(first, last, out);
+ }
+
+ template <class VertexIterator, class OutputItFaces>
+ OutputItFaces
+ restore_Delaunay_and_give_new_faces(VertexIterator first,
+                                     VertexIterator last,
+                                     OutputItFaces out,
+                                     Sequential_tag = Sequential_tag()) {
+  // same as above, and outputs the two faces created by each flip
+  // a face can be output several times
+  restore_Delaunay_impl(first, last, out);
+  return out;
+ }
+
+#ifdef CGAL_LINKED_WITH_TBB
+ template <class VertexIterator>
+ size_type
+ restore_Delaunay(VertexIterator first, VertexIterator last, Parallel_tag) {
+  // same as above, with several threads
+  // the vertices in [first, last) must be distinct
+  internal::Cdt_2_parallel_flips<CDt> flips(*this);
+  return flips(first, last);
+ }
+
+ template <class VertexIterator, class OutputItFaces>
+ OutputItFaces
+ restore_Delaunay_and_give_new_faces(VertexIterator first,
+                                     VertexIterator last,
+                                     OutputItFaces out,
+                                     Parallel_tag) {
+  internal::Cdt_2_parallel_flips<CDt> flips(*this);
+  flips(first, last, out);
+  return out;
+ }
+#endif
+
+private:
+ template <class VertexIterator, class OutputItFaces>
+ size_type
+ restore_Delaunay_impl(VertexIterator first, VertexIterator last,
+                       OutputItFaces& out) {
+  // only the edges incident to the vertices and the edges of their
+  // links can have become non Delaunay, flips are propagated from them
+  // one vertex at a time, so that they stay local
+  size_type nb_flips = 0;
+  std::deque<Edge> edges;
+  for( ; first != last; ++first) {
+    Vertex_handle v = *first;
+    Face_circulator fc = this->incident_faces(v), done(fc);
+    int degree = 0;
+
+    do {
+      if((++degree) > 3) break;
+    } while(++fc != done);
+
+    fc = this->incident_faces(v);
+    done = fc;
+
+    // the edges incident to a vertex of degree 3 cannot be flipped
+    if(degree == 3) {
+      do {
+        int i = fc->index(v);
+        edges.push_back(Edge(fc, i));
+      } while(++fc != done);
+    } else {
+      do {
+        int i = fc->index(v);
+        edges.push_back(Edge(fc, i));
+        edges.push_back(Edge(fc, cw(i)));
+      } while(++fc != done);
+    }
+
+    while(!edges.empty()) {
+      Face_handle f = edges.front().first;
+      int i = edges.front().second;
+      edges.pop_front();
+      if (!is_flipable(f, i)) continue;
+      Face_handle fi = f->neighbor(i);
+      int mi = mirror_index(f, i);
+      flip(f, i);
+      ++nb_flips;
+      *out++ = f;
+      *out++ = fi;
+      edges.push_back(Edge(f, i));
+      edges.push_back(Edge(f, cw(i)));
+      edges.push_back(Edge(fi, cw(mi)));
+      edges.push_back(Edge(fi, mi));
+    }
+  }
+  return nb_flips;
+ }
+
+public:
+
  template <class OutputItFaces>
  OutputItFaces
  propagating_flip(List_edges & edges,
@@ -1009,6 +1130,94 @@ remove_constrained_edge(Face_handle f, int i)
   return;
 }
 
+template < class Gt, class Tds, class Itag >
+inline
+typename Constrained_Delaunay_triangulation_2<Gt,Tds,Itag>::Vertex_handle
+Constrained_Delaunay_triangulation_2<Gt,Tds,Itag>::
+move_if_no_collision(Vertex_handle v, const Point& p)
+  // moves vertex v to point p and returns the moved vertex
+  // if p is inside the kernel of the star of v, v keeps its handle and
+  // its data, and the constrained Delaunay property is restored by flips;
+  // otherwise v is removed and p is inserted as a new vertex
+  // if p is the point of another vertex, that vertex is returned
+  // and v is not moved
+  // precondition : there is no incident constraints
+{
+  return move_if_no_collision_and_give_new_faces(v, p, Emptyset_iterator());
+}
+
+template < class Gt, class Tds, class Itag >
+template < class OutputItFaces >
+typename Constrained_Delaunay_triangulation_2<Gt,Tds,Itag>::Vertex_handle
+Constrained_Delaunay_triangulation_2<Gt,Tds,Itag>::
+move_if_no_collision_and_give_new_faces(Vertex_handle v,
+                                        const Point& p,
+                                        OutputItFaces oif)
+  // same as move_if_no_collision, and outputs the faces created by the move
+  // when v is moved in place, the two faces of each flip are output
+  // otherwise the faces incident to the new vertex and the faces whose
+  // vertices are all former neighbors of v are output, which contain the
+  // new faces; a face can be output several times
+  // an infinite face is output only if the convex hull changed
+{
+  CGAL_triangulation_precondition( ! is_infinite(v));
+  CGAL_triangulation_precondition( ! are_there_incident_constraints(v));
+  if (v->point() == p) return v;
+
+  if (dimension() == 2 && ! this->from_convex_hull(v)) {
+    Point old = v->point();
+    v->set_point(p);
+    if (this->well_oriented(v)) {
+      restore_Delaunay_and_give_new_faces(&v, &v + 1, oif);
+      return v;
+    }
+    v->set_point(old);
+  }
+
+  Locate_type lt;
+  int li;
+  Face_handle loc = locate(p, lt, li, v->face());
+  if (lt == Ctr::VERTEX) return loc->vertex(li);
+
+  // the faces filling the hole left by v have their vertices among its
+  // neighbors, the infinite one included when v is on the convex hull
+  std::vector<Vertex_handle> neighbors;
+  bool on_convex_hull = false;
+  if (dimension() > 0) {
+    Vertex_circulator vc = this->incident_vertices(v), vdone(vc);
+    do {
+      if (! is_infinite(vc)) neighbors.push_back(vc);
+      else on_convex_hull = true;
+    } while(++vc != vdone);
+  }
+  const std::size_t nb_finite_neighbors = neighbors.size();
+  if (on_convex_hull) neighbors.push_back(this->infinite_vertex());
+
+  // start the location of p next to the hole left by v
+  remove(v);
+  Face_handle start;
+  if (nb_finite_neighbors != 0) start = neighbors.front()->face();
+  Vertex_handle new_v = insert(p, start);
+
+  if (dimension() < 2) return new_v;
+  Face_circulator fc = this->incident_faces(new_v), done(fc);
+  do { *oif++ = fc; } while(++fc != done);
+  for(std::size_t k = 0; k < nb_finite_neighbors; ++k) {
+    fc = this->incident_faces(neighbors[k]);
+    done = fc;
+    do {
+      if (std::find(neighbors.begin(), neighbors.end(), fc->vertex(0))
+            != neighbors.end()
+          && std::find(neighbors.begin(), neighbors.end(), fc->vertex(1))
+            != neighbors.end()
+          && std::find(neighbors.begin(), neighbors.end(), fc->vertex(2))
+            != neighbors.end())
+        *oif++ = fc;
+    } while(++fc != done);
+  }
+  return new_v;
+}
+
 
 template < class Gt, class Tds, class Itag >
 bool
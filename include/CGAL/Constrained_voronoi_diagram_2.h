@@ -22,6 +22,7 @@
 #include <CGAL/iterator.h>
 #include <CGAL/tuple.h>
 #include <CGAL/Kernel/global_functions_2.h>
+#include <CGAL/Delaunay_mesh_face_base_with_circumcenter_2.h>
 
 namespace CGAL {
 
@@ -225,6 +226,26 @@ public:
     }
   }
 
+  // blind test for the faces on both sides of the constrained edges
+  // of [first, last), which must all be tagged not blind beforehand
+  // puts the faces tagged blind in blind_faces
+  template <typename EdgeIterator, typename OutputIterator>
+  OutputIterator tag_faces_blind(EdgeIterator first,
+                                 EdgeIterator last,
+                                 OutputIterator blind_faces)
+  {
+    if(m_cdt.dimension() < 2)
+      return blind_faces;
+
+    for(; first != last; ++first)
+    {
+      Edge edge = *first;
+      blind_faces = tag_neighbors_blind(edge, blind_faces);
+      blind_faces = tag_neighbors_blind(m_cdt.mirror_edge(edge), blind_faces);
+    }
+    return blind_faces;
+  }
+
 private:
   // test face for blindness with respect to the edge constraint
   void tag_face_blind(Face_handle& f, const Edge& constraint)
@@ -250,6 +271,14 @@ private:
   // tags with their sights, with respect to the Edge constraint,
   // seed and its neighbor faces, on the same side of Edge than seed.
   void tag_neighbors_blind(const Edge& constraint)
+  {
+    tag_neighbors_blind(constraint, Emptyset_iterator());
+  }
+
+  // same as above, and puts the faces tagged blind in blind_faces
+  template <typename OutputIterator>
+  OutputIterator tag_neighbors_blind(const Edge& constraint,
+                                     OutputIterator blind_faces)
   {
     CGAL_assertion(m_cdt.is_constrained(constraint));
     Face_handle seed = constraint.first;
@@ -268,9 +297,13 @@ private:
         faces.pop();
         this->tag_face_blind(f, constraint);
         if(f->is_blind())
+        {
+          *blind_faces++ = f;
           this->push_unvisited_neighbors(f, faces);
+        }
       }
     }
+    return blind_faces;
   }
 
   // puts in the stack the unvisited (un-tagged) neighbor faces of f
@@ -332,16 +365,18 @@ private:
     Face_circulator face = m_cdt.incident_faces(v);
     Face_circulator end = face;
     Face_circulator next = face;
+    Point cc_face = circumcenter(face);
 
     CGAL_For_all(face, end)
     {
       next++;
-      Line line(m_cdt.circumcenter(face), m_cdt.circumcenter(next));
+      const Point cc_next = circumcenter(next);
+      Line line(cc_face, cc_next);
       Point intersect;
 
       if(!face->is_blind()) //face sees
       {
-        polygon.push_back(m_cdt.circumcenter(face));
+        polygon.push_back(cc_face);
         if(next->is_blind())  //next doesn't
         {
           CGAL_assertion(do_intersect(line, m_cdt.segment(next->blinding_constraint())));
@@ -379,6 +414,7 @@ private:
           //else: it's the same constraint--> do nothing
         }
       }
+      cc_face = cc_next;
     }//end CGAL_For_all
 
     std::size_t nbp = polygon.size();
@@ -388,6 +424,12 @@ private:
     return oit;
   }
 
+  // from the cache of the face when it has one
+  Point circumcenter(const Face_handle& f) const
+  {
+    return Mesh_2::internal::face_circumcenter(m_cdt, f);
+  }
+
   template <typename OutputIterator>
   OutputIterator infinite_cvd_cell(Vertex_handle ,
                                    OutputIterator oit) const
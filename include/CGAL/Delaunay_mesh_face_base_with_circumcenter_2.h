@@ -0,0 +1,253 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// Face base of Delaunay_mesh_face_base_2 that caches the circumcenter and
+// the squared circumradius of the face, after
+// Delaunay_triangulation_cell_base_with_circumcenter_3.
+
+
+#ifndef CGAL_DELAUNAY_MESH_FACE_BASE_WITH_CIRCUMCENTER_2_H
+#define CGAL_DELAUNAY_MESH_FACE_BASE_WITH_CIRCUMCENTER_2_H
+
+#include <CGAL/license/Mesh_2.h>
+
+#include <CGAL/Delaunay_mesh_face_base_2.h>
+#include <CGAL/Has_member.h>
+#include <CGAL/tags.h>
+
+#include <atomic>
+#include <utility>
+
+namespace CGAL {
+
+// The cache is computed on first use. Several threads can read the
+// circumcenter of the same face at once: one of them fills the cache and
+// the others compute it without caching.
+//
+// Changing the vertices of the face invalidates the cache. Changing the
+// point of a vertex does not: the caches of its incident faces must then be
+// invalidated with invalidate_circumcenter(), as Mesh_global_optimizer_2
+// does.
+template <class Gt,
+          class Fb = Delaunay_mesh_face_base_2<Gt> >
+class Delaunay_mesh_face_base_with_circumcenter_2 : public Fb
+{
+  typedef typename Gt::Point_2 Point;
+  typedef typename Gt::FT      FT;
+
+  // States of the cache
+  enum { INVALID = 0, BEING_SET = 1, VALID = 2 };
+
+public:
+  typedef Gt Geom_traits;
+  typedef typename Fb::Vertex_handle Vertex_handle;
+  typedef typename Fb::Face_handle Face_handle;
+
+  template < typename TDS2 >
+  struct Rebind_TDS {
+    typedef typename Fb::template Rebind_TDS<TDS2>::Other Fb2;
+    typedef Delaunay_mesh_face_base_with_circumcenter_2<Gt,Fb2> Other;
+  };
+
+  Delaunay_mesh_face_base_with_circumcenter_2()
+    : Fb(), state_(INVALID) {}
+
+  Delaunay_mesh_face_base_with_circumcenter_2(Vertex_handle v0,
+                                              Vertex_handle v1,
+                                              Vertex_handle v2)
+    : Fb(v0,v1,v2), state_(INVALID) {}
+
+  Delaunay_mesh_face_base_with_circumcenter_2(Vertex_handle v0,
+                                              Vertex_handle v1,
+                                              Vertex_handle v2,
+                                              Face_handle n0,
+                                              Face_handle n1,
+                                              Face_handle n2)
+    : Fb(v0,v1,v2,n0,n1,n2), state_(INVALID) {}
+
+  Delaunay_mesh_face_base_with_circumcenter_2
+    (const Delaunay_mesh_face_base_with_circumcenter_2& f)
+    : Fb(f), state_(INVALID)
+  {
+    copy_cache(f);
+  }
+
+  Delaunay_mesh_face_base_with_circumcenter_2&
+  operator=(const Delaunay_mesh_face_base_with_circumcenter_2& f)
+  {
+    Fb::operator=(f);
+    state_ = INVALID;
+    copy_cache(f);
+    return *this;
+  }
+
+  void invalidate_circumcenter()
+  {
+    state_.store(INVALID, std::memory_order_relaxed);
+  }
+
+  // We must override the functions that modify the vertices.
+  void set_vertex(int i, Vertex_handle v)
+  {
+    invalidate_circumcenter();
+    Fb::set_vertex(i, v);
+  }
+
+  void set_vertices()
+  {
+    invalidate_circumcenter();
+    Fb::set_vertices();
+  }
+
+  void set_vertices(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2)
+  {
+    invalidate_circumcenter();
+    Fb::set_vertices(v0, v1, v2);
+  }
+
+  Point circumcenter(const Geom_traits& gt = Geom_traits()) const
+  {
+    if(state_.load(std::memory_order_acquire) == VALID)
+    {
+      CGAL_expensive_assertion(
+        gt.construct_circumcenter_2_object()(this->vertex(0)->point(),
+                                             this->vertex(1)->point(),
+                                             this->vertex(2)->point())
+        == circumcenter_);
+      return circumcenter_;
+    }
+    return set_cache(gt).first;
+  }
+
+  FT squared_circumradius(const Geom_traits& gt = Geom_traits()) const
+  {
+    if(state_.load(std::memory_order_acquire) == VALID)
+      return squared_circumradius_;
+    return set_cache(gt).second;
+  }
+
+private:
+  std::pair<Point, FT> set_cache(const Geom_traits& gt) const
+  {
+    const Point& p0 = this->vertex(0)->point();
+    const Point cc = gt.construct_circumcenter_2_object()(
+      p0, this->vertex(1)->point(), this->vertex(2)->point());
+    const FT sq_r = gt.compute_squared_distance_2_object()(cc, p0);
+
+    char expected = INVALID;
+    if(state_.compare_exchange_strong(expected, BEING_SET,
+                                      std::memory_order_relaxed))
+    {
+      circumcenter_ = cc;
+      squared_circumradius_ = sq_r;
+      state_.store(VALID, std::memory_order_release);
+    }
+    return std::make_pair(cc, sq_r);
+  }
+
+  void copy_cache(const Delaunay_mesh_face_base_with_circumcenter_2& f)
+  {
+    if(f.state_.load(std::memory_order_acquire) == VALID)
+    {
+      circumcenter_ = f.circumcenter_;
+      squared_circumradius_ = f.squared_circumradius_;
+      state_.store(VALID, std::memory_order_relaxed);
+    }
+  }
+
+  mutable std::atomic<char> state_;
+  mutable Point circumcenter_;
+  mutable FT squared_circumradius_;
+};
+
+namespace Mesh_2 {
+namespace internal {
+
+CGAL_GENERATE_MEMBER_DETECTOR(invalidate_circumcenter);
+
+// Circumcenter and squared circumradius of a finite face of tr, from the
+// cache of the face when it has one
+template <typename Tr>
+typename Tr::Geom_traits::Point_2
+face_circumcenter(const Tr& tr, const typename Tr::Face_handle& f, Tag_true)
+{
+  return f->circumcenter(tr.geom_traits());
+}
+
+template <typename Tr>
+typename Tr::Geom_traits::Point_2
+face_circumcenter(const Tr& tr, const typename Tr::Face_handle& f, Tag_false)
+{
+  return tr.circumcenter(f);
+}
+
+template <typename Tr>
+typename Tr::Geom_traits::Point_2
+face_circumcenter(const Tr& tr, const typename Tr::Face_handle& f)
+{
+  return face_circumcenter(tr, f, Boolean_tag<
+    has_invalidate_circumcenter<typename Tr::Face>::value>());
+}
+
+template <typename Tr>
+typename Tr::Geom_traits::FT
+face_squared_circumradius(const Tr& tr,
+                          const typename Tr::Face_handle& f,
+                          Tag_true)
+{
+  return f->squared_circumradius(tr.geom_traits());
+}
+
+template <typename Tr>
+typename Tr::Geom_traits::FT
+face_squared_circumradius(const Tr& tr,
+                          const typename Tr::Face_handle& f,
+                          Tag_false)
+{
+  return tr.geom_traits().compute_squared_distance_2_object()(
+    tr.circumcenter(f), f->vertex(0)->point());
+}
+
+template <typename Tr>
+typename Tr::Geom_traits::FT
+face_squared_circumradius(const Tr& tr, const typename Tr::Face_handle& f)
+{
+  return face_squared_circumradius(tr, f, Boolean_tag<
+    has_invalidate_circumcenter<typename Tr::Face>::value>());
+}
+
+// Invalidates the caches of the faces incident to v, after its point changed
+template <typename Tr>
+void invalidate_incident_circumcenters(const Tr&,
+                                       const typename Tr::Vertex_handle&,
+                                       Tag_false)
+{}
+
+template <typename Tr>
+void invalidate_incident_circumcenters(const Tr& tr,
+                                       const typename Tr::Vertex_handle& v,
+                                       Tag_true)
+{
+  typename Tr::Face_circulator fc = tr.incident_faces(v), done(fc);
+  do {
+    fc->invalidate_circumcenter();
+  } while(++fc != done);
+}
+
+template <typename Tr>
+void invalidate_incident_circumcenters(const Tr& tr,
+                                       const typename Tr::Vertex_handle& v)
+{
+  if(tr.dimension() < 2)
+    return;
+  invalidate_incident_circumcenters(tr, v, Boolean_tag<
+    has_invalidate_circumcenter<typename Tr::Face>::value>());
+}
+
+} // namespace internal
+} // namespace Mesh_2
+
+} // namespace CGAL
+
+#endif // CGAL_DELAUNAY_MESH_FACE_BASE_WITH_CIRCUMCENTER_2_H
@@ -47,16 +47,59 @@ namespace Mesh_2
           const CDT& cdt,
           const Sizing_field& sizing_field = Sizing_field()) const
     {
+      FT mass, energy;
+      return (*this)(v, cdt, sizing_field, mass, energy);
+    }
+
+    /**
+     * Returns the move of \c v, and sets \c mass to the mass of its cell
+     * and \c energy to the CVT energy of its cell, the integral of the
+     * density times the squared distance to \c v. The gradient of the
+     * total energy with respect to the point of \c v is -2 mass move.
+     */
+    Vector_2 operator()(Vertex_handle v,
+          const CDT& cdt,
+          const Sizing_field& sizing_field,
+          FT& mass,
+          FT& energy) const
+    {
+      mass = energy = FT(0);
       if(cdt.are_there_incident_constraints(v))
         return CGAL::NULL_VECTOR;
 
-      Point_2 p = v->point();
       Vector_2 move = CGAL::NULL_VECTOR;
-      FT sum_masses(0);
+      if(!cell_moments(v, cdt, sizing_field, move, mass, energy))
+        return CGAL::NULL_VECTOR; //center of mass is at infinity!
+      return move;
+    }
+
+    /// CVT energy of the cell of \c v, which may be constrained. 0 for
+    /// cells of the convex hull.
+    FT energy(Vertex_handle v,
+              const CDT& cdt,
+              const Sizing_field& sizing_field = Sizing_field()) const
+    {
+      Vector_2 move = CGAL::NULL_VECTOR;
+      FT mass(0), energy(0);
+      if(!cell_moments(v, cdt, sizing_field, move, mass, energy))
+        return FT(0);
+      return energy;
+    }
+
+  private:
+    // Returns false if the cell of v is empty or infinite
+    bool cell_moments(Vertex_handle v,
+                      const CDT& cdt,
+                      const Sizing_field& sizing_field,
+                      Vector_2& move,
+                      FT& sum_masses,
+                      FT& energy) const
+    {
+      Point_2 p = v->point();
 
       Cvd_cell cell = CGAL::dual(cdt, v);
       if(cell.is_infinite() || cell.is_empty())
-        return CGAL::NULL_VECTOR; //center of mass is at infinity!
+        return false;
 
       CGAL_assertion(cell.number_of_vertices() > 2);
 
@@ -70,29 +113,52 @@ namespace Mesh_2
         Point_2 tri_centroid = CGAL::centroid(tri);
 
         // Compute mass
-        FT density = density_2d(tri_centroid, sizing_field);
+        FT density = density_2d(tri_centroid, v, sizing_field);
         FT abs_area = CGAL::abs(compute_area(tri[0], tri[1], tri[2]));
         FT mass = abs_area * density;
 
         move = move + mass * Vector_2(p, tri_centroid);
         sum_masses += mass;
+
+        // Second moment of the triangle about its vertex p
+        Vector_2 a(p, tri[1]), b(p, tri[2]);
+        energy += mass * (a * a + b * b + a * b) / FT(6);
       }
 
       CGAL_assertion(sum_masses != 0.0);
-      return move / sum_masses;
+      move = move / sum_masses;
+      return true;
     }
 
-  private:
     FT density_2d(const Point_2& p,
+                  const Vertex_handle& v,
                   const Sizing_field& sizing_field) const
     {
-      FT s = sizing_field(p);
+      FT s = size_at(p, v, sizing_field, 0);
       CGAL_assertion( s > 0. );
 
       // 1 / s^(d+2)
       return ( 1/(s*s*s*s) );
     }
 
+    // Sizing fields that locate p in the triangulation, as
+    // Mesh_sizing_field does, start from a face of v: it is next to p, and
+    // the faces located before may have been deleted by the moves since.
+    template <typename SF>
+    static auto size_at(const Point_2& p, const Vertex_handle& v,
+                        const SF& sizing_field, int)
+      -> decltype(sizing_field(p, v))
+    {
+      return sizing_field(p, v);
+    }
+
+    template <typename SF>
+    static FT size_at(const Point_2& p, const Vertex_handle&,
+                      const SF& sizing_field, long)
+    {
+      return sizing_field(p);
+    }
+
 #ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
   public:
     static std::string name() { return std::string("Lloyd"); }
@@ -21,20 +21,37 @@
   #define CGAL_MESH_2_OPTIMIZER_VERBOSE
 #endif
 
-#include <CGAL/Timer.h>
+#include <CGAL/Real_timer.h>
 #include <CGAL/Origin.h>
 #include <CGAL/Mesh_optimization_return_code.h>
 #include <CGAL/Delaunay_mesh_size_criteria_2.h>
 #include <CGAL/Delaunay_mesher_2.h>
 #include <CGAL/Constrained_voronoi_diagram_2.h>
-
+#include <CGAL/Delaunay_mesh_face_base_with_circumcenter_2.h>
+#include <CGAL/Has_member.h>
+#include <CGAL/hilbert_sort.h>
+#include <CGAL/property_map.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+#include <CGAL/STL_Extension/internal/info_check.h>
+#include <CGAL/tags.h>
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
 #include <vector>
 #include <list>
+#include <memory>
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include <iterator>
+#include <type_traits>
+
+#ifdef CGAL_LINKED_WITH_TBB
+# include <tbb/blocked_range.h>
+# include <tbb/parallel_for.h>
+#endif
 
-#include <boost/lambda/lambda.hpp>
-#include <boost/lambda/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/math/constants/constants.hpp>
 
@@ -42,8 +59,117 @@ namespace CGAL {
 
 namespace Mesh_2 {
 
+namespace internal {
+
+// Per-vertex data that must survive a vertex being relocated by removal and
+// reinsertion: the sizing info and, when the vertex base has one, the info.
+template <typename Vertex,
+          bool has_info = CGAL::internal::Has_typedef_Info<Vertex>::value>
+class Relocated_vertex_data_2
+{
+  typedef typename Vertex::FT FT;
+
+public:
+  explicit Relocated_vertex_data_2(const Vertex& v)
+    : sizing_info_(v.sizing_info())
+  {}
+
+  void restore(Vertex& v) const
+  {
+    v.set_sizing_info(sizing_info_);
+  }
+
+private:
+  FT sizing_info_;
+};
+
+template <typename Vertex>
+class Relocated_vertex_data_2<Vertex, true>
+  : public Relocated_vertex_data_2<Vertex, false>
+{
+  typedef Relocated_vertex_data_2<Vertex, false> Base;
+
+public:
+  explicit Relocated_vertex_data_2(const Vertex& v)
+    : Base(v)
+    , info_(v.info())
+  {}
+
+  void restore(Vertex& v) const
+  {
+    Base::restore(v);
+    v.info() = info_;
+  }
+
+private:
+  typename Vertex::Info info_;
+};
+
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+// The infos of the finite vertices of a triangulation, sorted, or nothing
+// when the vertex base has no info. Several vertices may share an info, as
+// the vertices that were not in the input of the executable do.
+template <typename Tr,
+          bool has_info =
+            CGAL::internal::Has_typedef_Info<typename Tr::Vertex>::value>
+class Vertex_infos_2
+{
+public:
+  explicit Vertex_infos_2(const Tr&) {}
+  bool operator==(const Vertex_infos_2&) const { return true; }
+};
+
+template <typename Tr>
+class Vertex_infos_2<Tr, true>
+{
+public:
+  explicit Vertex_infos_2(const Tr& tr)
+  {
+    for(typename Tr::Finite_vertices_iterator vit = tr.finite_vertices_begin();
+        vit != tr.finite_vertices_end();
+        ++vit )
+      infos_.push_back(vit->info());
+    std::sort(infos_.begin(), infos_.end());
+  }
+
+  bool operator==(const Vertex_infos_2& other) const
+  {
+    return infos_ == other.infos_;
+  }
+
+private:
+  std::vector<typename Tr::Vertex::Info> infos_;
+};
+#endif
+
+// Move functions with an energy member give the CVT energy of the cells,
+// as Lloyd_move_2 does
+CGAL_GENERATE_MEMBER_DETECTOR(energy);
+
+} // end namespace internal
+
+/// How Mesh_global_optimizer_2 applies the moves of an iteration
+enum Move_update_policy
+{
+  /// Each vertex is relocated in turn, restoring the Delaunay property
+  /// around it before the next one moves
+  VERTEX_BY_VERTEX_MOVES,
+  /// All vertices are moved first, and a single flip pass restores the
+  /// Delaunay property. Vertices whose move would invert a face are
+  /// relocated one at a time afterwards. With \c Parallel_tag the flip
+  /// pass runs on several threads.
+  BATCH_MOVES,
+  /// Each vertex is relocated as soon as its move is computed, so that the
+  /// next moves see it at its new position (Gauss-Seidel iteration).
+  /// Vertices are visited in Hilbert order. The vertices next to a
+  /// constrained edge or a blind face are moved last, from moves computed
+  /// together. Moves are computed sequentially, even with \c Parallel_tag.
+  GAUSS_SEIDEL_MOVES
+};
+
 template <typename CDT,
-          typename MoveFunction>
+          typename MoveFunction,
+          typename Concurrency_tag = Sequential_tag>
 class Mesh_global_optimizer_2
 {
   // Types
@@ -62,14 +188,30 @@ class Mesh_global_optimizer_2
   typedef typename Gt::Vector_2         Vector_2;
 
   typedef typename std::vector<Face_handle>                 Face_vector;
-  typedef typename std::set<Vertex_handle>                  Vertex_set;
-  typedef typename std::list<FT>                            FT_list;
-  typedef typename std::pair<Vertex_handle,Point_2>         Move;
+  typedef typename std::vector<Vertex_handle>               Vertex_vector;
+  typedef typename std::vector<Vector_2>                    Vector_vector;
+  typedef typename std::vector<FT>                          FT_vector;
+  // A move refers to its vertex by index in the moving vertices
+  typedef typename std::pair<std::size_t,Point_2>           Move;
 
   typedef std::vector<Move>   Moves_vector;
 
+  // A constrained edge by its vertices, which never move
+  typedef std::pair<Vertex_handle,Vertex_handle>            Constrained_edge;
+  typedef std::vector<Constrained_edge>                     Constrained_edge_vector;
+
+  typedef internal::Relocated_vertex_data_2<Vertex> Vertex_data;
+
   typedef typename MoveFunction::Sizing_field Sizing_field;
 
+  typedef Boolean_tag<internal::has_energy<MoveFunction>::value> Has_energy;
+
+#ifndef CGAL_LINKED_WITH_TBB
+  CGAL_static_assertion_msg(
+    !(std::is_convertible<Concurrency_tag, Parallel_tag>::value),
+    "In Mesh_global_optimizer_2, Parallel_tag can only be used with TBB");
+#endif
+
 public:
   /**
    * Constructor
@@ -85,6 +227,23 @@ public:
     , sizing_field_(cdt)
     , seeds_()
     , seeds_mark_(false)
+    , stop_ptr_(0)
+    , os_(&std::cout)
+    , update_policy_(VERTEX_BY_VERTEX_MOVES)
+    , active_set_(false)
+    , relaxation_(1)
+    , anderson_window_(0)
+    , lbfgs_memory_(0)
+    , big_moves_size_(1)
+    , big_moves_mean_(0)
+    , prev_sq_norm_(0)
+    , lbfgs_energy_(0)
+    , lbfgs_scale_(1)
+    , moves_length_(0)
+    , steps_length_(0)
+    , nb_flips_(0)
+    , constrained_edges_up_to_date_(false)
+    , marks_up_to_date_(false)
   {
   }
 
@@ -92,6 +251,54 @@ public:
   void set_time_limit(double time) { time_limit_ = time; }
   double time_limit() const { return time_limit_; }
 
+  /// Optimization stops after the current iteration once \c *stop_ptr is true
+  void set_stop_pointer(std::atomic<bool>* stop_ptr) { stop_ptr_ = stop_ptr; }
+
+  /// Verbose output goes to \c *os, or to \c std::cout if \c os is null
+  void set_output_stream(std::ostream* os) { os_ = os ? os : &std::cout; }
+
+  /// Update policy accessors
+  void set_update_policy(Move_update_policy policy) { update_policy_ = policy; }
+  Move_update_policy update_policy() const { return update_policy_; }
+
+  /// When \c true, an iteration only computes the moves of the vertices
+  /// whose neighborhood changed during the previous one: the vertices that
+  /// moved, their neighbors and the vertices of the faces created by flips
+  /// or reinsertions. A frozen vertex moves again once its neighborhood
+  /// changes.
+  void set_active_set(bool active_set) { active_set_ = active_set; }
+  bool active_set() const { return active_set_; }
+
+  /// Over-relaxation factor: vertices move by \c relaxation times their
+  /// move. A vertex takes its plain move when the longer step would invert
+  /// one of its faces or increase the energy of its current Voronoi cell,
+  /// which is always the case from 2 on. With Anderson acceleration, it is
+  /// the mixing factor.
+  void set_relaxation(const FT& relaxation)
+  {
+    CGAL_precondition(relaxation > 0);
+    relaxation_ = relaxation;
+  }
+  const FT& relaxation() const { return relaxation_; }
+
+  /// Anderson acceleration: each step combines the moves of the last
+  /// \c window iterations, 0 for none. A vertex takes its plain move when
+  /// its step would invert one of its faces, and the history restarts when
+  /// the moves grow. It keeps two vectors per moving vertex and iteration
+  /// of the window, and is ignored with \c GAUSS_SEIDEL_MOVES.
+  void set_anderson_window(std::size_t window) { anderson_window_ = window; }
+  std::size_t anderson_window() const { return anderson_window_; }
+
+  /// Quasi-Newton steps: each step follows the L-BFGS direction of the CVT
+  /// energy over the last \c memory iterations, 0 for none. The plain
+  /// moves precondition the direction. When the energy does not decrease
+  /// enough, the next iteration halves the step instead (backtracking line
+  /// search). It needs a move function that gives the energy of the cells,
+  /// as Lloyd_move_2 does. It takes precedence over Anderson acceleration
+  /// and is ignored with \c GAUSS_SEIDEL_MOVES and with the active set.
+  void set_lbfgs_memory(std::size_t memory) { lbfgs_memory_ = memory; }
+  std::size_t lbfgs_memory() const { return lbfgs_memory_; }
+
   /** The value type of \a InputIterator should be \c Point, and represents
       seeds.
   */
@@ -112,43 +319,76 @@ public:
   {
     running_time_.reset();
     running_time_.start();
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+    initial_infos_.reset(new internal::Vertex_infos_2<CDT>(cdt_));
+#endif
 
-    // Fill set containing moving vertices
-    Vertex_set moving_vertices;
+    // Fill vector containing moving vertices. Frozen vertices are removed
+    // from it, and relocated vertices are replaced in place, so iterating
+    // over it follows the order of the triangulation vertices.
+    Vertex_vector moving_vertices;
+    moving_vertices.reserve(cdt_.number_of_vertices());
+    static_vertices_.clear();
     for(typename Tr::Finite_vertices_iterator
       vit = cdt_.finite_vertices_begin();
       vit != cdt_.finite_vertices_end();
       ++vit )
     {
       if(!cdt_.are_there_incident_constraints(vit))
-        moving_vertices.insert(vit);
+        moving_vertices.push_back(vit);
+      else if ( use_lbfgs() )
+        static_vertices_.push_back(vit);
     }
 
+    // In-place moves follow the order of moving_vertices, make it a
+    // Hilbert order so that consecutive moves are close to each other
+    if ( update_policy_ == GAUSS_SEIDEL_MOVES )
+      hilbert_sort(moving_vertices);
+    clear_anderson_history();
+    clear_lbfgs_history();
+
   double initial_vertices_nb = static_cast<double>(moving_vertices.size());
 #ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
   double step_begin = running_time_.time();
-  std::cout << "Running " << Mf::name() << "-smoothing..." << std::endl;
-  std::cout << "vertices=" << initial_vertices_nb << std::endl;
+  (*os_) << "Running " << Mf::name() << "-smoothing..." << std::endl;
+  (*os_) << "vertices=" << initial_vertices_nb << std::endl;
+  (*os_) << "update=" << update_policy_name() << std::endl;
 #endif
 
-    // Initialize big moves (stores the largest moves)
-    big_moves_.clear();
-    std::size_t big_moves_size = (std::max)(std::size_t(1),
-                                            moving_vertices.size()/100);
-    big_moves_.resize(big_moves_size, FT(0));
+    // Initialize big moves (the convergence criterion averages the largest
+    // moves)
+    big_moves_size_ = (std::max)(std::size_t(1), moving_vertices.size()/100);
+    big_moves_mean_ = FT(0);
 
     std::size_t nb_vertices_moved = (std::numeric_limits<std::size_t>::max)();
     bool convergence_stop = false;
 
     // Iterate
     double last_log = running_time_.time();
+    int nb_updates = 0;
     int i = -1;
     while ( ++i < nb_iterations && ! is_time_limit_reached() )
     {
+      if ( active_set_ && i > 0 )
+        update_active_set(moving_vertices);
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+      const double nb_active = static_cast<double>(moving_vertices.size());
+#endif
+
       this->before_move();
+      moves_length_ = steps_length_ = FT(0);
 
-      // Compute move for each vertex
-      Moves_vector moves = compute_moves(moving_vertices);
+      // Compute move for each vertex. In-place moves are applied as they
+      // are computed.
+      Moves_vector moves;
+      if ( update_policy_ == GAUSS_SEIDEL_MOVES )
+      {
+        move_vertices_in_place(moving_vertices);
+        this->after_move();
+        ++nb_updates;
+      }
+      else
+        moves = compute_moves(moving_vertices);
 
       //Pb with Freeze : sometimes a few vertices continue moving indefinitely
       //if the nb of moving vertices is < 2% of total nb AND does not decrease
@@ -163,25 +403,35 @@ public:
       }
 
       // Stop if convergence or time_limit is reached
-      if ( check_convergence() || is_time_limit_reached() || stopOptimizing )
+      if ( check_convergence() || is_time_limit_reached() || forced_stop() )
         break;
 
       // Update mesh with those moves
-      update_mesh(moves);
+      if ( update_policy_ != GAUSS_SEIDEL_MOVES )
+      {
+        update_mesh(moves, moving_vertices);
+        this->after_move();
+        ++nb_updates;
+      }
       nb_vertices_moved = moving_vertices.size();
 
-      this->after_move();
-
 #ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
       double time = running_time_.time();
       if (time > last_log + 5 || i == 1 || i == nb_iterations - 1)
       {
           double moving_vertices_size = static_cast<double>(moving_vertices.size());
-          std::cout
+          (*os_)
               << "iteration=" << i << ";"
               << "time=" << running_time_.time() << ";"
+              << "active=" << nb_active << ";"
               << "moved=" << moving_vertices_size << ";"
-              << "avgmove=" << sum_moves_ << ";"
+              << "avgmove=" << big_moves_mean_ << ";"
+              << "p50=" << move_percentiles_[2] << ";"
+              << "p90=" << move_percentiles_[1] << ";"
+              << "p99=" << move_percentiles_[0] << ";"
+              << "max=" << max_move_ << ";"
+              << "relax=" << effective_step() << ";"
+              << "flips=" << nb_flips_ << ";"
               << "step=" << time - step_begin << ";"
               << "avgstep=" << time / (i + 1) << std::endl;
           last_log = running_time_.time();
@@ -192,26 +442,28 @@ public:
 
     this->after_all_moves();
     running_time_.stop();
+    CGAL_USE(nb_updates);
 
 #ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
-    std::cout << "result=";
-    if (stopOptimizing)
-      std::cout << "aborted" << std::endl;
+    (*os_) << "result=";
+    if ( forced_stop() )
+      (*os_) << "aborted" << std::endl;
     else if(sq_freeze_ratio_ > 0. && moving_vertices.empty())
-      std::cout << "frozen" << std::endl;
+      (*os_) << "frozen" << std::endl;
     else if(sq_freeze_ratio_ > 0. && convergence_stop)
-      std::cout << "limited" << std::endl;
+      (*os_) << "limited" << std::endl;
     else if ( is_time_limit_reached() )
-      std::cout << "timeout" << std::endl;
+      (*os_) << "timeout" << std::endl;
     else if ( check_convergence() )
-      std::cout << "converged" << std::endl;
+      (*os_) << "converged" << std::endl;
     else if ( i >= nb_iterations )
-      std::cout << "iterations" << std::endl;
+      (*os_) << "iterations" << std::endl;
 
-    std::cout << "time=" << running_time_.time() << std::endl;
+    (*os_) << "iterations=" << nb_updates << std::endl;
+    (*os_) << "time=" << running_time_.time() << std::endl;
 #endif
 
-    if ( stopOptimizing )
+    if ( forced_stop() )
         return CONVERGENCE_REACHED;
     else if( sq_freeze_ratio_ > 0. && moving_vertices.empty() )
       return ALL_VERTICES_FROZEN;
@@ -229,51 +481,197 @@ public:
 
 private:
   /**
-   * Returns moves for vertices of set \c moving_vertices
+   * Returns moves for vertices of \c moving_vertices, and removes the frozen
+   * vertices from \c moving_vertices. Moves refer to their vertex by its
+   * index in \c moving_vertices after the removal.
    */
-  Moves_vector compute_moves(Vertex_set& moving_vertices)
+  Moves_vector compute_moves(Vertex_vector& moving_vertices)
   {
     typename Gt::Construct_translated_point_2 translate =
       Gt().construct_translated_point_2_object();
 
-    // Store new location of points which have to move
-    Moves_vector moves;
-    moves.reserve(moving_vertices.size());
-
-    // reset worst_move list
-    std::fill(big_moves_.begin(), big_moves_.end(), FT(0));
-
-    // Get move for each moving vertex
-    for ( typename Vertex_set::const_iterator vit = moving_vertices.begin() ;
-      vit != moving_vertices.end() ; )
+    const std::size_t nb_vertices = moving_vertices.size();
+    const bool lbfgs = use_lbfgs();
+    vertex_moves_.assign(nb_vertices, CGAL::NULL_VECTOR);
+    vertex_sq_ratios_.assign(nb_vertices, FT(0));
+    computed_.assign(nb_vertices, 0);
+    if ( lbfgs )
     {
-      Vertex_handle oldv = *vit;
-      Vector_2 move = compute_move(oldv);
-      ++vit;
+      vertex_masses_.assign(nb_vertices, FT(0));
+      vertex_energies_.assign(nb_vertices, FT(0));
+    }
 
-      if ( CGAL::NULL_VECTOR != move )
+#ifdef CGAL_LINKED_WITH_TBB
+    // Parallel
+    if (std::is_convertible<Concurrency_tag, Parallel_tag>::value)
+    {
+      std::atomic<bool> time_limit_reached(false);
+
+      tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, nb_vertices),
+        [&](const tbb::blocked_range<std::size_t>& r)
+        {
+          for(std::size_t i = r.begin() ; i != r.end() ; ++i)
+          {
+            if ( time_limit_reached.load(std::memory_order_relaxed) )
+              return;
+
+            compute_move(i, moving_vertices[i], lbfgs);
+
+            // Stop if time_limit_ is reached
+            if ( is_time_limit_reached() )
+            {
+              time_limit_reached = true;
+              return;
+            }
+          }
+        });
+    }
+    // Sequential
+    else
+#endif // CGAL_LINKED_WITH_TBB
+    {
+      // Get move for each moving vertex
+      for(std::size_t i = 0 ; i < nb_vertices ; ++i)
       {
-        Point_2 new_position = translate(oldv->point(), move);
-        moves.push_back(std::make_pair(oldv, new_position));
+        compute_move(i, moving_vertices[i], lbfgs);
+
+        // Stop if time_limit_ is reached
+        if ( is_time_limit_reached() )
+          break;
       }
-      else if(sq_freeze_ratio_ > 0.) //freezing ON
-        moving_vertices.erase(oldv);
+    }
 
-      // Stop if time_limit_ is reached
-      if ( is_time_limit_reached() )
-        break;
+    // Gather the moves in the order of moving_vertices, so that the result
+    // does not depend on the scheduling, and compact the frozen vertices out
+    Moves_vector moves;
+    moves.reserve(nb_vertices);
+    sq_move_ratios_.clear();
+
+    // The moves are compacted along, and so are the Anderson and L-BFGS
+    // histories
+    if ( prev_points_.size() != nb_vertices )
+      clear_anderson_history();
+    const bool keep_history = !prev_points_.empty();
+    if ( lbfgs_points_.size() != nb_vertices )
+      clear_lbfgs_history();
+    const bool keep_lbfgs_history = !lbfgs_points_.empty();
+
+    // The energy of the whole mesh, summed before the frozen vertices join
+    // the static ones. An iteration cut by the time limit misses energies,
+    // and is the last one anyway.
+    const bool all_computed =
+      std::find(computed_.begin(), computed_.end(), 0) == computed_.end();
+    FT energy = lbfgs && all_computed ? static_energy() : FT(0);
+
+    std::size_t nb_active = 0;
+    for(std::size_t i = 0 ; i < nb_vertices ; ++i)
+    {
+      const Vertex_handle v = moving_vertices[i];
+      if ( lbfgs )
+        energy += vertex_energies_[i];
+      if ( computed_[i] )
+      {
+        if ( CGAL::NULL_VECTOR != vertex_moves_[i] )
+        {
+          Point_2 new_position = translate(v->point(), vertex_moves_[i]);
+          moves.push_back(std::make_pair(nb_active, new_position));
+          sq_move_ratios_.push_back(vertex_sq_ratios_[i]);
+        }
+        else if(sq_freeze_ratio_ > 0.) //freezing ON
+        {
+          if ( lbfgs )
+            static_vertices_.push_back(v);
+          continue;
+        }
+      }
+      if ( keep_history )
+        move_anderson_history(i, nb_active);
+      if ( keep_lbfgs_history )
+        move_lbfgs_history(i, nb_active);
+      if ( lbfgs )
+        vertex_masses_[nb_active] = vertex_masses_[i];
+      vertex_moves_[nb_active] = vertex_moves_[i];
+      moving_vertices[nb_active++] = v;
     }
+    moving_vertices.resize(nb_active);
+    vertex_moves_.resize(nb_active);
+    if ( keep_history )
+      resize_anderson_history(nb_active);
+    if ( keep_lbfgs_history )
+      resize_lbfgs_history(nb_active);
+
+    update_big_moves();
+
+    // Replace the plain moves by the accelerated steps
+    const bool lbfgs_steps = lbfgs && all_computed;
+    const bool anderson_steps = !lbfgs && anderson_window_ > 0;
+    if ( lbfgs_steps )
+      compute_lbfgs_steps(moving_vertices, energy);
+    else if ( anderson_steps )
+      compute_anderson_steps(moving_vertices);
+    if ( lbfgs_steps || anderson_steps || (!lbfgs && relaxation_ != FT(1)) )
+    {
+      for(typename Moves_vector::iterator it = moves.begin() ;
+          it != moves.end() ;
+          ++it )
+      {
+        const Vertex_handle& v = moving_vertices[it->first];
+        const Vector_2& move = vertex_moves_[it->first];
+        const Vector_2 step = lbfgs_steps || anderson_steps
+          ? steps_[it->first] : relaxation_ * move;
+        it->second = translate(v->point(),
+          safeguarded_step(v, move, step, lbfgs_steps || anderson_steps));
+      }
+    }
+
     return moves;
   }
 
   /**
-   * Returns the move for vertex \c v
+   * Sets the move of moving vertex \c i, \c v, and for L-BFGS the mass and
+   * the energy of its cell
    */
-  Vector_2 compute_move(const Vertex_handle& v)
+  void compute_move(const std::size_t i, const Vertex_handle& v,
+                    const bool lbfgs)
+  {
+    if ( lbfgs )
+      vertex_moves_[i] = compute_move(v, vertex_sq_ratios_[i],
+                                      vertex_masses_[i], vertex_energies_[i],
+                                      Has_energy());
+    else
+      vertex_moves_[i] = compute_move(v, vertex_sq_ratios_[i]);
+    computed_[i] = 1;
+  }
+
+  /**
+   * Returns the move for vertex \c v, and sets \c sq_ratio to its squared
+   * length relative to the local size
+   */
+  Vector_2 compute_move(const Vertex_handle& v, FT& sq_ratio) const
   {
     // Get move from move function
-    Vector_2 move = move_function_(v, cdt_, sizing_field_);
+    return filter_move(v, move_function_(v, cdt_, sizing_field_), sq_ratio);
+  }
 
+  /// Same, also setting the mass and the energy of the cell of \c v
+  Vector_2 compute_move(const Vertex_handle& v, FT& sq_ratio,
+                        FT& mass, FT& energy, Tag_true) const
+  {
+    return filter_move(v,
+      move_function_(v, cdt_, sizing_field_, mass, energy), sq_ratio);
+  }
+
+  Vector_2 compute_move(const Vertex_handle& v, FT& sq_ratio,
+                        FT&, FT&, Tag_false) const
+  {
+    return compute_move(v, sq_ratio);
+  }
+
+  /// Returns \c move, or the null vector if \c v is frozen
+  Vector_2 filter_move(const Vertex_handle& v, const Vector_2& move,
+                       FT& sq_ratio) const
+  {
     FT local_sq_size = min_sq_circumradius(v);
     if ( FT(0) == local_sq_size )
       return CGAL::NULL_VECTOR;
@@ -284,9 +682,7 @@ private:
     if ( local_move_sq_ratio < sq_freeze_ratio_ )
       return CGAL::NULL_VECTOR;
 
-    // Update big moves
-    update_big_moves(local_move_sq_ratio);
-
+    sq_ratio = local_move_sq_ratio;
     return move;
   }
 
@@ -317,29 +713,63 @@ private:
 
   FT sq_circumradius(const Face_handle& f) const
   {
-    Point_2 cc = cdt_.circumcenter(f);
-    Point_2 p0 = f->vertex(0)->point();
-    return (cc - p0) * (cc - p0);
+    return internal::face_squared_circumradius(cdt_, f);
   }
 
   /**
-   * update big_moves_ vector with new_sq_move value
+   * Selects the largest moves of sq_move_ratios_ and updates the mean used
+   * as convergence criterion (and the move percentiles when verbose)
    */
-  void update_big_moves(const FT& new_sq_move)
+  void update_big_moves()
   {
-    if ( new_sq_move > big_moves_.back() )
-    {
-      // Remove last value
-      big_moves_.pop_back();
+    typedef typename FT_vector::iterator Iterator;
+    const std::greater<FT> larger;
+
+    const Iterator begin = sq_move_ratios_.begin();
+    const Iterator end = sq_move_ratios_.end();
+    const std::size_t nb_moves = sq_move_ratios_.size();
 
-      // Insert value at the right place
-      typename FT_list::iterator pos = std::find_if(
-        big_moves_.begin(),
-        big_moves_.end(),
-        boost::lambda::_1 < new_sq_move );
+    // The largest moves, in decreasing order. When fewer vertices moved,
+    // the missing moves count as zero.
+    const std::size_t nb_big_moves = (std::min)(big_moves_size_, nb_moves);
+    if ( nb_big_moves < nb_moves )
+      std::nth_element(begin, begin + nb_big_moves, end, larger);
+    std::sort(begin, begin + nb_big_moves, larger);
 
-      big_moves_.insert(pos, new_sq_move);
+    FT sum(0);
+    for(std::size_t i = 0 ; i < nb_big_moves ; ++i)
+      sum += CGAL::sqrt(sq_move_ratios_[i]);
+    big_moves_mean_ = sum/FT(big_moves_size_);
+
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+    // Percentiles, by rank in decreasing order. Ranks below nb_big_moves are
+    // already sorted, each selection leaves the larger values before it.
+    const double percentiles[3] = { 0.99, 0.9, 0.5 };
+    std::size_t first = nb_big_moves;
+    for(int i = 0 ; i < 3 ; ++i)
+    {
+      if ( nb_moves == 0 )
+      {
+        move_percentiles_[i] = FT(0);
+        continue;
+      }
+      std::size_t rank = nb_moves - 1
+        - static_cast<std::size_t>(percentiles[i] * double(nb_moves - 1));
+      if ( rank >= first )
+      {
+        std::nth_element(begin + first, begin + rank, end, larger);
+        first = rank + 1;
+      }
+      move_percentiles_[i] = CGAL::sqrt(sq_move_ratios_[rank]);
     }
+    max_move_ = nb_moves == 0 ? FT(0) : CGAL::sqrt(sq_move_ratios_[0]);
+#endif
+  }
+
+  bool forced_stop() const
+  {
+    return stop_ptr_ != 0
+        && stop_ptr_->load(std::memory_order_acquire);
   }
 
   bool is_time_limit_reached() const
@@ -350,50 +780,877 @@ private:
 
   bool check_convergence() const
   {
-    namespace bl = boost::lambda;
-
-    FT sum(0);
-    for(typename FT_list::const_iterator it = big_moves_.begin();
-        it != big_moves_.end();
-        ++it)
-      sum += CGAL::sqrt(*it);
-
-#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
-    sum_moves_ = sum/FT(big_moves_.size());
-#endif
-
-    return ( sum/FT(big_moves_.size()) < convergence_ratio_ );
+    return ( big_moves_mean_ < convergence_ratio_ );
   }
 
-  void update_mesh(const Moves_vector& moves)
+  void update_mesh(const Moves_vector& moves, Vertex_vector& moving_vertices)
   {
+    // the blind faces may be deleted by the moves
+    clear_blind_faces();
+
+    if ( update_policy_ == BATCH_MOVES )
+    {
+      update_mesh_in_batch(moves, moving_vertices);
+      return;
+    }
+
     // Apply moves in triangulation
     for(typename Moves_vector::const_iterator it = moves.begin() ;
         it != moves.end() ;
         ++it )
     {
-      const Vertex_handle& v = it->first;
-      const Point_2& new_position = it->second;
-      const FT size = v->sizing_info();
+      relocate(*it, moving_vertices);
+
+      if( is_time_limit_reached() )
+        break;
+    }
+  }
+
+  void relocate(const Move& move, Vertex_vector& moving_vertices)
+  {
+    Vertex_handle& v = moving_vertices[move.first];
+    const Vertex_data data(*v);
+
+    // Most moves stay inside the star of v, and only update its point and
+    // flip a few edges. Otherwise v is reinserted, possibly in the same
+    // slot, so its data is restored onto the returned vertex. When the
+    // target is the point of another vertex, that vertex is returned
+    // unchanged, without new faces: v did not move, and both vertices
+    // keep their data and their place in moving_vertices.
+    new_faces_.clear();
+    Vertex_handle new_v = cdt_.move_if_no_collision_and_give_new_faces(
+      v, move.second, std::back_inserter(new_faces_));
+    if ( new_v != v && new_faces_.empty() )
+      return;
+
+    data.restore(*new_v);
+    v = new_v;
+    // the flips and the new faces reset their circumcenters, but not
+    // the faces that kept their vertices
+    internal::invalidate_incident_circumcenters(cdt_, new_v);
+
+    if ( active_set_ )
+    {
+      mark_dirty(new_v);
+      mark_dirty(new_faces_.begin(), new_faces_.end());
+    }
+
+    // the faces created by a reinsertion need an in-domain mark
+    // (flipped faces already have the right one)
+    if ( marks_up_to_date_ && !new_faces_.empty() )
+      marks_up_to_date_ = inherit_in_domain_marks();
+  }
+
+  /**
+   * Gives the faces of new_faces_ the in-domain mark of the faces around
+   * them. The constrained edges do not move, so a face has the mark of
+   * the faces it shares an unconstrained edge with. Returns false if some
+   * faces are only surrounded by constrained edges and new faces, or if
+   * the convex hull changed, which can change the marks of whole
+   * components.
+   */
+  bool inherit_in_domain_marks()
+  {
+    for(typename Face_vector::const_iterator it = new_faces_.begin() ;
+        it != new_faces_.end() ;
+        ++it )
+      if ( cdt_.is_infinite(*it) )
+        return false;
+
+    std::sort(new_faces_.begin(), new_faces_.end());
+    new_faces_.erase(std::unique(new_faces_.begin(), new_faces_.end()),
+                     new_faces_.end());
+
+    std::vector<char> visited(new_faces_.size(), 0);
+    Face_vector component;
+    for(std::size_t k = 0 ; k < new_faces_.size() ; ++k)
+    {
+      if ( visited[k] )
+        continue;
 
-      //cdt_.move(v, new_position);
-      //function not available, see Constrained_triangulation_2
-      cdt_.remove(v);
-      Vertex_handle new_v = cdt_.insert(new_position);
+      // the new faces connected to this one by unconstrained edges
+      // share its mark, look for an old face next to them
+      visited[k] = 1;
+      component.assign(1, new_faces_[k]);
+      bool found = false;
+      bool mark = false;
+      for(std::size_t j = 0 ; j < component.size() ; ++j)
+      {
+        const Face_handle f = component[j];
+        for(int i = 0 ; i < 3 ; ++i)
+        {
+          if ( f->is_constrained(i) )
+            continue;
+          const Face_handle n = f->neighbor(i);
+          typename Face_vector::iterator pos =
+            std::lower_bound(new_faces_.begin(), new_faces_.end(), n);
+          if ( pos == new_faces_.end() || *pos != n )
+          {
+            if ( !found )
+            {
+              found = true;
+              mark = n->is_in_domain();
+            }
+          }
+          else if ( !visited[pos - new_faces_.begin()] )
+          {
+            visited[pos - new_faces_.begin()] = 1;
+            component.push_back(n);
+          }
+        }
+      }
 
-      new_v->set_sizing_info(size);
+      if ( !found )
+        return false;
+      for(typename Face_vector::iterator it = component.begin() ;
+          it != component.end() ;
+          ++it )
+        (*it)->set_in_domain(mark);
+    }
+    return true;
+  }
 
+  /**
+   * Moves all vertices in place, puts back those with an inverted incident
+   * face, restores the Delaunay property with one flip pass and then
+   * relocates the vertices that were put back one at a time
+   */
+  void update_mesh_in_batch(const Moves_vector& moves,
+                            Vertex_vector& moving_vertices)
+  {
+    std::vector<Point_2> old_points;
+    std::vector<std::size_t> applied;
+    Moves_vector deferred;
+    old_points.reserve(moves.size());
+    applied.reserve(moves.size());
+
+    for(std::size_t k = 0 ; k < moves.size() ; ++k)
+    {
+      const Vertex_handle& v = moving_vertices[moves[k].first];
+      if ( cdt_.from_convex_hull(v) )
+      {
+        deferred.push_back(moves[k]);
+        continue;
+      }
+      old_points.push_back(v->point());
+      applied.push_back(k);
+      v->set_point(moves[k].second);
+    }
+
+    // Putting a vertex back can invert a face of a neighbour that moved,
+    // so repeat until all faces are counterclockwise
+    bool reverted = true;
+    while ( reverted )
+    {
+      reverted = false;
+      std::size_t nb_applied = 0;
+      for(std::size_t j = 0 ; j < applied.size() ; ++j)
+      {
+        const std::size_t k = applied[j];
+        const Vertex_handle& v = moving_vertices[moves[k].first];
+        if ( cdt_.well_oriented(v) )
+        {
+          old_points[nb_applied] = old_points[j];
+          applied[nb_applied++] = k;
+          continue;
+        }
+        v->set_point(old_points[j]);
+        deferred.push_back(moves[k]);
+        reverted = true;
+      }
+      applied.resize(nb_applied);
+      old_points.resize(nb_applied);
+    }
+
+    Vertex_vector moved;
+    moved.reserve(applied.size());
+    for(std::size_t j = 0 ; j < applied.size() ; ++j)
+      moved.push_back(moving_vertices[moves[applied[j]].first]);
+    if ( active_set_ )
+    {
+      Face_vector flipped;
+      cdt_.restore_Delaunay_and_give_new_faces(moved.begin(), moved.end(),
+                                               std::back_inserter(flipped),
+                                               Concurrency_tag());
+      nb_flips_ = flipped.size() / 2;
+      mark_dirty(flipped.begin(), flipped.end());
+      for(typename Vertex_vector::const_iterator it = moved.begin() ;
+          it != moved.end() ;
+          ++it )
+        mark_dirty(*it);
+    }
+    else
+      nb_flips_ = cdt_.restore_Delaunay(moved.begin(), moved.end(),
+                                        Concurrency_tag());
+    for(typename Vertex_vector::const_iterator it = moved.begin() ;
+        it != moved.end() ;
+        ++it )
+      internal::invalidate_incident_circumcenters(cdt_, *it);
+
+    for(typename Moves_vector::const_iterator it = deferred.begin() ;
+        it != deferred.end() ;
+        ++it )
+    {
       if( is_time_limit_reached() )
         break;
+
+      relocate(*it, moving_vertices);
+    }
+  }
+
+  /**
+   * Computes the move of each vertex of \c moving_vertices against the
+   * current mesh and relocates it at once, removing the frozen vertices
+   * from \c moving_vertices. Moving a vertex next to a constrained edge or
+   * a blind face changes which faces are blind, so these vertices are
+   * moved last, from moves computed together as in update_mesh().
+   */
+  void move_vertices_in_place(Vertex_vector& moving_vertices)
+  {
+    typename Gt::Construct_translated_point_2 translate =
+      Gt().construct_translated_point_2_object();
+
+    const std::size_t nb_vertices = moving_vertices.size();
+    sq_move_ratios_.clear();
+    std::vector<std::size_t> deferred;
+
+    std::size_t nb_active = 0;
+    std::size_t i = 0;
+    for( ; i < nb_vertices && !is_time_limit_reached() ; ++i)
+    {
+      const Vertex_handle v = moving_vertices[i];
+      moving_vertices[nb_active] = v;
+      if ( is_near_blind_faces(v) )
+      {
+        deferred.push_back(nb_active++);
+        continue;
+      }
+
+      FT sq_ratio(0);
+      const Vector_2 move = compute_move(v, sq_ratio);
+      if ( CGAL::NULL_VECTOR == move )
+      {
+        if ( sq_freeze_ratio_ == 0. ) //freezing OFF
+          ++nb_active;
+        continue;
+      }
+      sq_move_ratios_.push_back(sq_ratio);
+      relocate(Move(nb_active, translate(v->point(), relaxed(v, move))),
+               moving_vertices);
+
+      // The move usually stays away from the blind faces, otherwise
+      // blindness is updated before the next move is computed
+      if ( is_near_blind_faces(moving_vertices[nb_active])
+        || is_near_blind_faces(new_faces_.begin(), new_faces_.end()) )
+        update_blind_faces();
+      ++nb_active;
+    }
+    // Vertices not reached before the time limit keep moving
+    for( ; i < nb_vertices ; ++i)
+      moving_vertices[nb_active++] = moving_vertices[i];
+    moving_vertices.resize(nb_active);
+
+    Moves_vector moves;
+    std::vector<char> frozen(moving_vertices.size(), 0);
+    for(std::size_t j = 0 ; j < deferred.size() ; ++j)
+    {
+      if ( is_time_limit_reached() )
+        break;
+
+      const Vertex_handle& v = moving_vertices[deferred[j]];
+      FT sq_ratio(0);
+      const Vector_2 move = compute_move(v, sq_ratio);
+      if ( CGAL::NULL_VECTOR == move )
+      {
+        frozen[deferred[j]] = (sq_freeze_ratio_ > 0.);
+        continue;
+      }
+      moves.push_back(Move(deferred[j], translate(v->point(), relaxed(v, move))));
+      sq_move_ratios_.push_back(sq_ratio);
+    }
+    update_mesh(moves, moving_vertices);
+
+    nb_active = 0;
+    for(std::size_t j = 0 ; j < moving_vertices.size() ; ++j)
+      if ( !frozen[j] )
+        moving_vertices[nb_active++] = moving_vertices[j];
+    moving_vertices.resize(nb_active);
+
+    update_big_moves();
+  }
+
+  /// Marks \c v and its neighbors dirty
+  void mark_dirty(const Vertex_handle& v)
+  {
+    dirty_vertices_.push_back(v);
+    typename Tr::Vertex_circulator vc = cdt_.incident_vertices(v), done(vc);
+    if ( vc == 0 )
+      return;
+    do {
+      dirty_vertices_.push_back(vc);
+    } while(++vc != done);
+  }
+
+  /// Marks the vertices of the faces of [first, last) dirty
+  template <typename FaceIterator>
+  void mark_dirty(FaceIterator first, FaceIterator last)
+  {
+    for( ; first != last ; ++first)
+      for(int i = 0 ; i < 3 ; ++i)
+        dirty_vertices_.push_back((*first)->vertex(i));
+  }
+
+  /**
+   * Replaces \c moving_vertices by the dirty vertices that can move, in
+   * the order of the triangulation vertices (in Hilbert order for
+   * in-place moves), so that the result does not depend on the order in
+   * which they were marked
+   */
+  void update_active_set(Vertex_vector& moving_vertices)
+  {
+    std::sort(dirty_vertices_.begin(), dirty_vertices_.end());
+    dirty_vertices_.erase(std::unique(dirty_vertices_.begin(),
+                                      dirty_vertices_.end()),
+                          dirty_vertices_.end());
+
+    const Vertex_vector previous_vertices = anderson_window_ > 0
+      ? moving_vertices : Vertex_vector();
+    moving_vertices.clear();
+    for(typename Tr::Finite_vertices_iterator
+          vit = cdt_.finite_vertices_begin();
+        vit != cdt_.finite_vertices_end();
+        ++vit )
+    {
+      if ( std::binary_search(dirty_vertices_.begin(), dirty_vertices_.end(),
+                              Vertex_handle(vit))
+        && !cdt_.are_there_incident_constraints(vit) )
+        moving_vertices.push_back(vit);
+    }
+    dirty_vertices_.clear();
+
+    if ( update_policy_ == GAUSS_SEIDEL_MOVES )
+      hilbert_sort(moving_vertices);
+    // the history is indexed by moving vertex
+    if ( moving_vertices != previous_vertices )
+      clear_anderson_history();
+  }
+
+  /// Returns \c move over-relaxed, if it passes the safeguards
+  Vector_2 relaxed(const Vertex_handle& v, const Vector_2& move)
+  {
+    if ( relaxation_ == FT(1) )
+      return move;
+    return safeguarded_step(v, move, relaxation_ * move, false);
+  }
+
+  /**
+   * Returns \c step, the accelerated replacement of \c move for \c v, if
+   * moving \c v by \c step keeps its incident faces counterclockwise and,
+   * for an over-relaxed step, brings \c v closer to the centroid its plain
+   * move goes to (the energy of its current Voronoi cell decreases).
+   * Returns \c move otherwise. Anderson steps (\c anderson_step) combine
+   * several iterations and may go further than the centroid. Vertices of the convex hull
+   * always take their plain move.
+   */
+  Vector_2 safeguarded_step(const Vertex_handle& v,
+                            const Vector_2& move,
+                            const Vector_2& step,
+                            const bool anderson_step)
+  {
+    const FT move_length = CGAL::sqrt(move * move);
+    moves_length_ += move_length;
+
+    const Vector_2 overshoot = step - move;
+    if ( (anderson_step || overshoot * overshoot < move * move)
+      && keeps_faces_oriented(v, v->point() + step) )
+    {
+      steps_length_ += CGAL::sqrt(step * step);
+      return step;
+    }
+    steps_length_ += move_length;
+    return move;
+  }
+
+  bool keeps_faces_oriented(const Vertex_handle& v, const Point_2& p) const
+  {
+    typename Gt::Orientation_2 orientation =
+      cdt_.geom_traits().orientation_2_object();
+
+    Face_circulator fc = cdt_.incident_faces(v), done(fc);
+    do {
+      if ( cdt_.is_infinite(fc) )
+        return false;
+      const int i = fc->index(v);
+      if ( orientation(p, fc->vertex(cdt_.ccw(i))->point(),
+                          fc->vertex(cdt_.cw(i))->point()) != LEFT_TURN )
+        return false;
+    } while(++fc != done);
+    return true;
+  }
+
+  /// Length of the steps taken over the length of the plain moves
+  FT effective_step() const
+  {
+    return moves_length_ > 0 ? steps_length_ / moves_length_ : FT(1);
+  }
+
+  /**
+   * Fills \c steps_ with the Anderson steps of the vertices of
+   * \c moving_vertices, whose plain moves are in \c vertex_moves_. The
+   * moves are the residuals of the Lloyd fixed point iteration. The step
+   * mixes the last moves with the coefficients that minimize the norm of
+   * the linearized residual, found by least squares over the differences
+   * between consecutive iterations.
+   */
+  void compute_anderson_steps(const Vertex_vector& moving_vertices)
+  {
+    const std::size_t n = moving_vertices.size();
+
+    double sq_norm = 0;
+    for(std::size_t i = 0 ; i < n ; ++i)
+      sq_norm += CGAL::to_double(vertex_moves_[i] * vertex_moves_[i]);
+
+    if ( !prev_points_.empty() )
+    {
+      // The residual grew, the history does not describe the iteration
+      // anymore: restart from the last difference
+      if ( sq_norm > prev_sq_norm_ )
+      {
+        dx_history_.clear();
+        df_history_.clear();
+      }
+      else if ( dx_history_.size() == anderson_window_ )
+      {
+        dx_history_.erase(dx_history_.begin());
+        df_history_.erase(df_history_.begin());
+      }
+      dx_history_.push_back(Vector_vector(n));
+      df_history_.push_back(Vector_vector(n));
+      Vector_vector& dx = dx_history_.back();
+      Vector_vector& df = df_history_.back();
+      for(std::size_t i = 0 ; i < n ; ++i)
+      {
+        dx[i] = moving_vertices[i]->point() - prev_points_[i];
+        df[i] = vertex_moves_[i] - prev_moves_[i];
+      }
+    }
+    prev_points_.resize(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      prev_points_[i] = moving_vertices[i]->point();
+    prev_moves_ = vertex_moves_;
+    prev_sq_norm_ = sq_norm;
+
+    // Normal equations of the least squares problem, regularized so that
+    // nearly parallel differences do not blow the coefficients up
+    const std::size_t m = df_history_.size();
+    std::vector<double> a(m * m, 0.), gamma(m, 0.);
+    for(std::size_t j = 0 ; j < m ; ++j)
+    {
+      for(std::size_t i = 0 ; i < n ; ++i)
+        gamma[j] += CGAL::to_double(df_history_[j][i] * vertex_moves_[i]);
+      for(std::size_t k = 0 ; k <= j ; ++k)
+      {
+        double dot = 0;
+        for(std::size_t i = 0 ; i < n ; ++i)
+          dot += CGAL::to_double(df_history_[j][i] * df_history_[k][i]);
+        a[j * m + k] = a[k * m + j] = dot;
+      }
+    }
+    double trace = 0;
+    for(std::size_t j = 0 ; j < m ; ++j)
+      trace += a[j * m + j];
+    for(std::size_t j = 0 ; j < m ; ++j)
+      a[j * m + j] += 1e-10 * trace;
+    if ( !solve_linear_system(a, gamma) )
+      std::fill(gamma.begin(), gamma.end(), 0.);
+
+    steps_.resize(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+    {
+      Vector_2 step = relaxation_ * vertex_moves_[i];
+      for(std::size_t j = 0 ; j < m ; ++j)
+        step = step - FT(gamma[j]) * (dx_history_[j][i]
+                                      + relaxation_ * df_history_[j][i]);
+      steps_[i] = step;
+    }
+  }
+
+  /**
+   * Solves the square system \c a x = \c b by Gaussian elimination with
+   * partial pivoting, \c b receiving x. Returns false if \c a is singular.
+   */
+  static bool solve_linear_system(std::vector<double>& a,
+                                  std::vector<double>& b)
+  {
+    const std::size_t m = b.size();
+    for(std::size_t c = 0 ; c < m ; ++c)
+    {
+      std::size_t pivot = c;
+      for(std::size_t r = c + 1 ; r < m ; ++r)
+        if ( std::abs(a[r * m + c]) > std::abs(a[pivot * m + c]) )
+          pivot = r;
+      if ( a[pivot * m + c] == 0. )
+        return false;
+      if ( pivot != c )
+      {
+        for(std::size_t k = 0 ; k < m ; ++k)
+          std::swap(a[c * m + k], a[pivot * m + k]);
+        std::swap(b[c], b[pivot]);
+      }
+      for(std::size_t r = c + 1 ; r < m ; ++r)
+      {
+        const double factor = a[r * m + c] / a[c * m + c];
+        for(std::size_t k = c ; k < m ; ++k)
+          a[r * m + k] -= factor * a[c * m + k];
+        b[r] -= factor * b[c];
+      }
+    }
+    for(std::size_t c = m ; c-- > 0 ; )
+    {
+      for(std::size_t k = c + 1 ; k < m ; ++k)
+        b[c] -= a[c * m + k] * b[k];
+      b[c] /= a[c * m + c];
+    }
+    return true;
+  }
+
+  /// Moves the history of moving vertex \c i to index \c j <= \c i
+  void move_anderson_history(std::size_t i, std::size_t j)
+  {
+    prev_points_[j] = prev_points_[i];
+    prev_moves_[j] = prev_moves_[i];
+    for(std::size_t k = 0 ; k < dx_history_.size() ; ++k)
+    {
+      dx_history_[k][j] = dx_history_[k][i];
+      df_history_[k][j] = df_history_[k][i];
+    }
+  }
+
+  void resize_anderson_history(std::size_t n)
+  {
+    prev_points_.resize(n);
+    prev_moves_.resize(n);
+    for(std::size_t k = 0 ; k < dx_history_.size() ; ++k)
+    {
+      dx_history_[k].resize(n);
+      df_history_[k].resize(n);
+    }
+  }
+
+  void clear_anderson_history()
+  {
+    prev_points_.clear();
+    prev_moves_.clear();
+    dx_history_.clear();
+    df_history_.clear();
+  }
+
+  bool use_lbfgs() const
+  {
+    return lbfgs_memory_ > 0 && Has_energy::value
+        && update_policy_ != GAUSS_SEIDEL_MOVES && !active_set_;
+  }
+
+  /// Energy of the cells of the vertices that do not move
+  FT static_energy() const
+  {
+    const std::size_t n = static_vertices_.size();
+    FT_vector energies(n, FT(0));
+#ifdef CGAL_LINKED_WITH_TBB
+    if (std::is_convertible<Concurrency_tag, Parallel_tag>::value)
+    {
+      tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, n),
+        [&](const tbb::blocked_range<std::size_t>& r)
+        {
+          for(std::size_t i = r.begin() ; i != r.end() ; ++i)
+            energies[i] = cell_energy(static_vertices_[i], Has_energy());
+        });
+    }
+    else
+#endif // CGAL_LINKED_WITH_TBB
+    {
+      for(std::size_t i = 0 ; i < n ; ++i)
+        energies[i] = cell_energy(static_vertices_[i], Has_energy());
     }
+
+    // summed in order, so that the result does not depend on the threads
+    FT energy(0);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      energy += energies[i];
+    return energy;
+  }
+
+  FT cell_energy(const Vertex_handle& v, Tag_true) const
+  {
+    return move_function_.energy(v, cdt_, sizing_field_);
+  }
+
+  FT cell_energy(const Vertex_handle&, Tag_false) const
+  {
+    return FT(0);
   }
 
+  /**
+   * Fills \c steps_ with the L-BFGS steps of the vertices of
+   * \c moving_vertices, whose plain moves are in \c vertex_moves_ and
+   * whose cell masses are in \c vertex_masses_. \c energy is the energy
+   * of the mesh, whose gradient at a vertex is -2 mass move.
+   *
+   * The previous step is checked first (Armijo condition). If the energy
+   * did not decrease enough, the step is halved: the vertices go back
+   * towards the point the step started from, and the history is kept.
+   * After a few halvings, the history restarts from the current points.
+   * Otherwise the step and the change of the gradient join the history,
+   * when the curvature along the step is positive, and the new direction
+   * comes from the two-loop recursion, with the plain moves as initial
+   * inverse Hessian: without history, the step is the plain move.
+   */
+  void compute_lbfgs_steps(const Vertex_vector& moving_vertices,
+                           const FT& energy)
+  {
+    const double sufficient_decrease = 1e-4;
+    const double min_scale = 1. / 16;
+
+    const std::size_t n = moving_vertices.size();
+    Vector_vector gradients(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      gradients[i] = FT(-2) * vertex_masses_[i] * vertex_moves_[i];
+
+    steps_.resize(n);
+    if ( !lbfgs_points_.empty() )
+    {
+      // The step actually taken, as safeguards may have replaced some
+      Vector_vector dx(n);
+      double slope = 0;
+      for(std::size_t i = 0 ; i < n ; ++i)
+      {
+        dx[i] = moving_vertices[i]->point() - lbfgs_points_[i];
+        slope += CGAL::to_double(lbfgs_gradients_[i] * dx[i]);
+      }
+
+      const bool decreased = CGAL::to_double(energy)
+        <= CGAL::to_double(lbfgs_energy_) + sufficient_decrease * slope;
+      if ( !decreased && lbfgs_scale_ > min_scale )
+      {
+        lbfgs_scale_ /= 2;
+        for(std::size_t i = 0 ; i < n ; ++i)
+          steps_[i] = lbfgs_scale_ * lbfgs_directions_[i] - dx[i];
+        return;
+      }
+
+      if ( decreased )
+      {
+        Vector_vector dg(n);
+        double curvature = 0;
+        for(std::size_t i = 0 ; i < n ; ++i)
+        {
+          dg[i] = gradients[i] - lbfgs_gradients_[i];
+          curvature += CGAL::to_double(dx[i] * dg[i]);
+        }
+        if ( curvature > 0 )
+        {
+          if ( dx_lbfgs_history_.size() == lbfgs_memory_ )
+          {
+            dx_lbfgs_history_.pop_front();
+            dg_lbfgs_history_.pop_front();
+            curvatures_.pop_front();
+          }
+          dx_lbfgs_history_.push_back(Vector_vector());
+          dx_lbfgs_history_.back().swap(dx);
+          dg_lbfgs_history_.push_back(Vector_vector());
+          dg_lbfgs_history_.back().swap(dg);
+          curvatures_.push_back(curvature);
+        }
+      }
+      else
+      {
+        dx_lbfgs_history_.clear();
+        dg_lbfgs_history_.clear();
+        curvatures_.clear();
+      }
+    }
+
+    // Two-loop recursion: the direction is minus the approximate inverse
+    // Hessian times the gradient
+    const std::size_t m = curvatures_.size();
+    Vector_vector q = gradients;
+    std::vector<double> alpha(m, 0.);
+    for(std::size_t j = m ; j-- > 0 ; )
+    {
+      double dot = 0;
+      for(std::size_t i = 0 ; i < n ; ++i)
+        dot += CGAL::to_double(dx_lbfgs_history_[j][i] * q[i]);
+      alpha[j] = dot / curvatures_[j];
+      for(std::size_t i = 0 ; i < n ; ++i)
+        q[i] = q[i] - FT(alpha[j]) * dg_lbfgs_history_[j][i];
+    }
+    for(std::size_t i = 0 ; i < n ; ++i)
+      q[i] = vertex_masses_[i] > 0 ? q[i] / (FT(2) * vertex_masses_[i])
+                                   : CGAL::NULL_VECTOR;
+    for(std::size_t j = 0 ; j < m ; ++j)
+    {
+      double dot = 0;
+      for(std::size_t i = 0 ; i < n ; ++i)
+        dot += CGAL::to_double(dg_lbfgs_history_[j][i] * q[i]);
+      const double beta = dot / curvatures_[j];
+      for(std::size_t i = 0 ; i < n ; ++i)
+        q[i] = q[i] + FT(alpha[j] - beta) * dx_lbfgs_history_[j][i];
+    }
+
+    double slope = 0;
+    for(std::size_t i = 0 ; i < n ; ++i)
+    {
+      steps_[i] = -q[i];
+      slope += CGAL::to_double(gradients[i] * steps_[i]);
+    }
+    // Not a descent direction: restart from the plain moves
+    if ( m > 0 && !(slope < 0) )
+    {
+      dx_lbfgs_history_.clear();
+      dg_lbfgs_history_.clear();
+      curvatures_.clear();
+      steps_ = vertex_moves_;
+    }
+
+    lbfgs_points_.resize(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      lbfgs_points_[i] = moving_vertices[i]->point();
+    lbfgs_gradients_.swap(gradients);
+    lbfgs_directions_ = steps_;
+    lbfgs_energy_ = energy;
+    lbfgs_scale_ = 1;
+  }
+
+  /// Moves the L-BFGS history of moving vertex \c i to index \c j <= \c i
+  void move_lbfgs_history(std::size_t i, std::size_t j)
+  {
+    lbfgs_points_[j] = lbfgs_points_[i];
+    lbfgs_gradients_[j] = lbfgs_gradients_[i];
+    lbfgs_directions_[j] = lbfgs_directions_[i];
+    for(std::size_t k = 0 ; k < curvatures_.size() ; ++k)
+    {
+      dx_lbfgs_history_[k][j] = dx_lbfgs_history_[k][i];
+      dg_lbfgs_history_[k][j] = dg_lbfgs_history_[k][i];
+    }
+  }
+
+  void resize_lbfgs_history(std::size_t n)
+  {
+    lbfgs_points_.resize(n);
+    lbfgs_gradients_.resize(n);
+    lbfgs_directions_.resize(n);
+    for(std::size_t k = 0 ; k < curvatures_.size() ; ++k)
+    {
+      dx_lbfgs_history_[k].resize(n);
+      dg_lbfgs_history_[k].resize(n);
+    }
+  }
+
+  void clear_lbfgs_history()
+  {
+    lbfgs_points_.clear();
+    lbfgs_gradients_.clear();
+    lbfgs_directions_.clear();
+    dx_lbfgs_history_.clear();
+    dg_lbfgs_history_.clear();
+    curvatures_.clear();
+    lbfgs_scale_ = 1;
+  }
+
+  // Whether moving v can change which faces are blind: a face incident
+  // to v is blind, has a constrained edge or is next to a blind face
+  bool is_near_blind_faces(const Vertex_handle& v) const
+  {
+    Face_circulator fc = cdt_.incident_faces(v), done(fc);
+    do {
+      if ( is_near_blind_faces(fc) )
+        return true;
+    } while(++fc != done);
+    return false;
+  }
+
+  template <typename FaceIterator>
+  bool is_near_blind_faces(FaceIterator first, FaceIterator last) const
+  {
+    for( ; first != last ; ++first)
+      if ( is_near_blind_faces(*first) )
+        return true;
+    return false;
+  }
+
+  bool is_near_blind_faces(const Face_handle& f) const
+  {
+    if ( f->is_blind() )
+      return true;
+    for(int i = 0 ; i < 3 ; ++i)
+      if ( f->is_constrained(i) || f->neighbor(i)->is_blind() )
+        return true;
+    return false;
+  }
+
+  /// Sorts \c vertices along a Hilbert curve
+  void hilbert_sort(Vertex_vector& vertices) const
+  {
+    std::vector<Point_2> points;
+    std::vector<std::size_t> indices;
+    points.reserve(vertices.size());
+    indices.reserve(vertices.size());
+    for(std::size_t i = 0 ; i < vertices.size() ; ++i)
+    {
+      points.push_back(vertices[i]->point());
+      indices.push_back(i);
+    }
+
+    typedef typename Pointer_property_map<Point_2>::type Pmap;
+    typedef Spatial_sort_traits_adapter_2<Gt,Pmap> Search_traits;
+    CGAL::hilbert_sort(indices.begin(), indices.end(),
+                       Search_traits(make_property_map(points),
+                                     cdt_.geom_traits()));
+
+    Vertex_vector sorted;
+    sorted.reserve(vertices.size());
+    for(std::size_t i = 0 ; i < indices.size() ; ++i)
+      sorted.push_back(vertices[indices[i]]);
+    vertices.swap(sorted);
+  }
+
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+  const char* update_policy_name() const
+  {
+    switch ( update_policy_ )
+    {
+    case BATCH_MOVES: return "batch";
+    case GAUSS_SEIDEL_MOVES: return "gauss-seidel";
+    default: return "vertex-by-vertex";
+    }
+  }
+#endif
+
   void before_move()
   {
     update_blind_faces();
   }
 
   void after_move()
+  {
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+    check_infos();
+#endif
+    // the moves kept the tags up to date
+    if ( marks_up_to_date_ )
+    {
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+      check_in_domain_marks();
+#endif
+      return;
+    }
+
+    mark_facets();
+    marks_up_to_date_ = true;
+  }
+
+  void mark_facets()
   {
     //update inside/outside tags
     typedef CGAL::Delaunay_mesh_size_criteria_2<CDT> Criteria;
@@ -411,12 +1668,151 @@ private:
     update_blind_faces();
   }
 
+  /**
+   * Updates blindness. Only the faces flooded from the constrained edges
+   * can be blind, so the faces tagged blind by the previous call are reset
+   * and the constrained edges are flooded again, instead of resetting all
+   * faces and looking for the constrained edges among all edges.
+   */
   void update_blind_faces()
   {
-    //update blindness
+    clear_blind_faces();
+    if ( cdt_.dimension() < 2 )
+      return;
+
+    CGAL::Constrained_voronoi_diagram_2<CDT> cvd(cdt_);
+    if ( !constrained_edges_up_to_date_ )
+    {
+      cvd.tag_all_faces_blind(false);
+      collect_constrained_edges();
+    }
+
+    std::vector<Edge> constraints;
+    constraints.reserve(constrained_edges_.size());
+    for(typename Constrained_edge_vector::const_iterator
+          it = constrained_edges_.begin() ;
+        it != constrained_edges_.end() ;
+        ++it )
+    {
+      Face_handle f;
+      int i;
+      if ( !cdt_.is_edge(it->first, it->second, f, i) )
+      {
+        // a vertex was inserted on this constrained edge
+        // and split it, look for the constrained edges again
+        constrained_edges_up_to_date_ = false;
+        update_blind_faces();
+        return;
+      }
+      constraints.push_back(Edge(f, i));
+    }
+
+    cvd.tag_faces_blind(constraints.begin(), constraints.end(),
+                        std::back_inserter(blind_faces_));
+
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+    check_blind_faces();
+#endif
+  }
+
+  void clear_blind_faces()
+  {
+    // the in-place moves can delete blind faces
+    for(typename Face_vector::iterator it = blind_faces_.begin() ;
+        it != blind_faces_.end() ;
+        ++it )
+      if ( cdt_.tds().faces().is_used(*it) )
+        (*it)->set_blind(false);
+    blind_faces_.clear();
+  }
+
+  void collect_constrained_edges()
+  {
+    constrained_edges_.clear();
+    for(typename CDT::Finite_edges_iterator eit = cdt_.finite_edges_begin() ;
+        eit != cdt_.finite_edges_end() ;
+        ++eit )
+    {
+      if ( !cdt_.is_constrained(*eit) )
+        continue;
+      const Face_handle& f = eit->first;
+      const int i = eit->second;
+      constrained_edges_.push_back(
+        Constrained_edge(f->vertex(cdt_.cw(i)), f->vertex(cdt_.ccw(i))));
+    }
+    constrained_edges_up_to_date_ = true;
+  }
+
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+  // Compares the in-domain marks of the faces with a full recomputation
+  void check_in_domain_marks()
+  {
+    std::vector<bool> in_domain;
+    for(typename CDT::All_faces_iterator fit = cdt_.all_faces_begin() ;
+        fit != cdt_.all_faces_end() ;
+        ++fit )
+      in_domain.push_back(fit->is_in_domain());
+
+    mark_facets();
+
+    std::size_t nb_differences = 0;
+    std::size_t k = 0;
+    for(typename CDT::All_faces_iterator fit = cdt_.all_faces_begin() ;
+        fit != cdt_.all_faces_end() ;
+        ++fit, ++k )
+      if ( fit->is_in_domain() != in_domain[k] )
+        ++nb_differences;
+
+    if ( nb_differences != 0 )
+      (*os_) << "in-domain marks differ from a full recomputation: "
+             << nb_differences << " faces" << std::endl;
+    CGAL_assertion(nb_differences == 0);
+  }
+
+  // Checks that the moves neither lost an info nor copied one onto
+  // another vertex: no two vertices share an info that only one vertex
+  // had before
+  void check_infos() const
+  {
+    const bool same_infos =
+      internal::Vertex_infos_2<CDT>(cdt_) == *initial_infos_;
+    if ( !same_infos )
+      (*os_) << "vertex infos differ from those before optimization"
+             << std::endl;
+    CGAL_assertion(same_infos);
+  }
+
+  // Compares the blindness of the faces with a full recomputation
+  void check_blind_faces()
+  {
+    std::vector<bool> blind;
+    for(typename CDT::All_faces_iterator fit = cdt_.all_faces_begin() ;
+        fit != cdt_.all_faces_end() ;
+        ++fit )
+      blind.push_back(fit->is_blind());
+
     CGAL::Constrained_voronoi_diagram_2<CDT> cvd(cdt_);
     cvd.tag_faces_blind();
+
+    std::size_t nb_differences = 0;
+    std::size_t k = 0;
+    blind_faces_.clear();
+    for(typename CDT::All_faces_iterator fit = cdt_.all_faces_begin() ;
+        fit != cdt_.all_faces_end() ;
+        ++fit, ++k )
+    {
+      if ( fit->is_blind() != blind[k] )
+        ++nb_differences;
+      if ( fit->is_blind() )
+        blind_faces_.push_back(fit);
+    }
+
+    if ( nb_differences != 0 )
+      (*os_) << "blind faces differ from a full recomputation: "
+             << nb_differences << " faces" << std::endl;
+    CGAL_assertion(nb_differences == 0);
   }
+#endif
 
 public:
 
@@ -471,12 +1867,77 @@ private:
   bool seeds_mark_;
 
   double time_limit_;
-  CGAL::Timer running_time_;
-
-  std::list<FT> big_moves_;
+  // Wall clock, so that jobs running in other threads don't use up the limit
+  CGAL::Real_timer running_time_;
+  std::atomic<bool>* stop_ptr_;
+  std::ostream* os_;
+  Move_update_policy update_policy_;
+  bool active_set_;
+  FT relaxation_;
+  std::size_t anderson_window_;
+  std::size_t lbfgs_memory_;
+
+  // Number of largest moves averaged by the convergence criterion
+  std::size_t big_moves_size_;
+  FT big_moves_mean_;
+  // Squared relative moves of the vertices moved by the last iteration
+  FT_vector sq_move_ratios_;
+  // Per moving vertex buffers of compute_moves, kept between iterations
+  Vector_vector vertex_moves_;
+  FT_vector vertex_sq_ratios_;
+  std::vector<char> computed_;
+  // Anderson acceleration: the positions and moves of the moving vertices
+  // at the last iteration, the differences between consecutive iterations
+  // (oldest first) and the resulting steps
+  std::vector<Point_2> prev_points_;
+  Vector_vector prev_moves_;
+  std::vector<Vector_vector> dx_history_;
+  std::vector<Vector_vector> df_history_;
+  Vector_vector steps_;
+  double prev_sq_norm_;
+  // L-BFGS: the cell masses and energies of the moving vertices, the
+  // vertices whose cells count in the energy but do not move (constrained
+  // or frozen), the points, gradients and direction at the start of the
+  // current step, and the differences of points and gradients between
+  // accepted steps (oldest first) with their curvatures
+  FT_vector vertex_masses_;
+  FT_vector vertex_energies_;
+  Vertex_vector static_vertices_;
+  std::vector<Point_2> lbfgs_points_;
+  Vector_vector lbfgs_gradients_;
+  Vector_vector lbfgs_directions_;
+  std::deque<Vector_vector> dx_lbfgs_history_;
+  std::deque<Vector_vector> dg_lbfgs_history_;
+  std::deque<double> curvatures_;
+  FT lbfgs_energy_;
+  FT lbfgs_scale_;
+  // Lengths of the plain moves and of the steps taken instead, this
+  // iteration
+  FT moves_length_;
+  FT steps_length_;
+  // Flips done by the last batch update
+  std::size_t nb_flips_;
+  // Faces tagged blind by the last update of blindness
+  Face_vector blind_faces_;
+  Constrained_edge_vector constrained_edges_;
+  bool constrained_edges_up_to_date_;
+  // Vertices whose neighborhood changed since the last update of the
+  // active set, possibly several times
+  Vertex_vector dirty_vertices_;
+  // Faces created by the last relocation
+  Face_vector new_faces_;
+  // False when the in-domain marks need a full pass
+  bool marks_up_to_date_;
+
+#ifdef CGAL_MESH_2_OPTIMIZER_DEBUG
+  // Infos of the vertices before optimization
+  std::unique_ptr<internal::Vertex_infos_2<CDT> > initial_infos_;
+#endif
 
 #ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
-  mutable FT sum_moves_;
+  // p99, p90 and p50 relative moves of the last iteration
+  FT move_percentiles_[3];
+  FT max_move_;
 #endif
 
 };
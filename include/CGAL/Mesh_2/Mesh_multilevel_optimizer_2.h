@@ -0,0 +1,641 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// Coarse-to-fine driver of Mesh_global_optimizer_2.
+
+
+#ifndef CGAL_MESH_2_MESH_MULTILEVEL_OPTIMIZER_2_H
+#define CGAL_MESH_2_MESH_MULTILEVEL_OPTIMIZER_2_H
+
+#include <CGAL/license/Mesh_2.h>
+
+#ifdef CGAL_MESH_2_VERBOSE
+  #define CGAL_MESH_2_OPTIMIZER_VERBOSE
+#endif
+
+#include <CGAL/Mesh_2/Mesh_global_optimizer_2.h>
+#include <CGAL/Mesh_2/Mesh_sizing_field.h>
+#include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Delaunay_mesh_vertex_base_2.h>
+#include <CGAL/Delaunay_mesh_size_criteria_2.h>
+#include <CGAL/Delaunay_mesher_2.h>
+#include <CGAL/Delaunay_mesh_face_base_with_circumcenter_2.h>
+#include <CGAL/Triangulation_data_structure_2.h>
+#include <CGAL/Triangulation_vertex_base_with_info_2.h>
+#include <CGAL/Mesh_optimization_return_code.h>
+#include <CGAL/Real_timer.h>
+#include <CGAL/Unique_hash_map.h>
+#include <CGAL/hilbert_sort.h>
+#include <CGAL/property_map.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace CGAL {
+
+namespace Mesh_2 {
+
+/**
+ * Runs Mesh_global_optimizer_2 on a hierarchy of vertex subsets, from the
+ * coarsest to the finest (the triangulation itself).
+ *
+ * Each level is a maximal independent set of the vertices of the level
+ * below, plus the vertices that cannot move or that bound the domain: the
+ * vertices of constrained edges and of the convex hull. Picking independent
+ * vertices rather than random ones, as Triangulation_hierarchy_2 does, keeps
+ * the coarse levels evenly spread, so that their moves correct the
+ * large-scale placement of the vertices and not the sampling.
+ *
+ * The coarsest level is optimized as the triangulation would be. Its moves
+ * are then interpolated to the vertices of the level below, linearly in the
+ * coarse faces that contained them at the start, and that level is smoothed
+ * for a few iterations, down to the triangulation. A vertex keeps its
+ * position when the moves have inverted its coarse face, or when the
+ * interpolated point is not inside a face of the domain of the optimized
+ * coarse level. Vertices interpolated or moved onto the same point are put
+ * back at their initial point. The triangulation is rebuilt with the
+ * interpolated points before its own optimization: the info and the
+ * sizing info of the vertices are kept, not the vertex handles.
+ *
+ * All levels use the sizing field of the triangulation before optimization.
+ * \c MoveFunction is instantiated with the triangulation of each level and
+ * its Mesh_sizing_field.
+ */
+template <typename CDT,
+          template <typename, typename> class MoveFunction,
+          typename Concurrency_tag = Sequential_tag>
+class Mesh_multilevel_optimizer_2
+{
+  // Types
+  typedef typename CDT::Geom_traits     Gt;
+  typedef typename CDT::Point           Point_2;
+  typedef typename CDT::Vertex_handle   Vertex_handle;
+  typedef typename CDT::Vertex          Vertex;
+  typedef typename Gt::FT               FT;
+  typedef typename Gt::Vector_2         Vector_2;
+
+  // The triangulation of a coarse level, whose vertices store their index
+  // in the triangulation
+  typedef Triangulation_vertex_base_with_info_2<std::size_t, Gt> Level_vb_base;
+  typedef Delaunay_mesh_vertex_base_2<Gt, Level_vb_base>         Level_vb;
+  typedef Delaunay_mesh_face_base_with_circumcenter_2<Gt>        Level_fb;
+  typedef Triangulation_data_structure_2<Level_vb, Level_fb>     Level_tds;
+  typedef Constrained_Delaunay_triangulation_2<Gt, Level_tds,
+                                               typename CDT::Itag> Level_tr;
+
+  template <typename Tr>
+  struct Optimizer
+  {
+    typedef Mesh_sizing_field<Tr, true, Concurrency_tag>       Sizing;
+    typedef MoveFunction<Tr, Sizing>                           Move;
+    typedef Mesh_global_optimizer_2<Tr, Move, Concurrency_tag> type;
+  };
+
+  typedef std::vector<std::size_t>                          Index_vector;
+  // A constrained edge by the indices of its vertices
+  typedef std::pair<std::size_t, std::size_t>               Index_edge;
+  typedef internal::Relocated_vertex_data_2<Vertex>         Vertex_data;
+
+  // A vertex missing from the next level, and the vertices and barycentric
+  // coordinates of the face of the next level that contained it
+  struct Prolongation
+  {
+    std::size_t vertex;
+    std::size_t face_vertices[3];
+    FT weights[3];
+  };
+  typedef std::vector<Prolongation>                         Prolongation_vector;
+
+  // Levels smaller than this are not worth optimizing apart
+  static const std::size_t min_level_size = 1000;
+
+  // Index of a vertex of the triangulation
+  struct Vertex_index
+  {
+    const Unique_hash_map<Vertex_handle, std::size_t>& indices;
+
+    template <typename Handle>
+    std::size_t operator()(const Handle& v) const { return indices[v]; }
+  };
+
+  // Index of a vertex of a coarse level
+  struct Info_index
+  {
+    template <typename Handle>
+    std::size_t operator()(const Handle& v) const { return v->info(); }
+  };
+
+public:
+  /**
+   * Constructor. \c nb_levels counts the triangulation, and \c
+   * smoothing_iterations is the number of iterations of the levels between
+   * the coarsest and the triangulation.
+   */
+  Mesh_multilevel_optimizer_2(CDT& cdt,
+                              const FT& convergence_ratio,
+                              const FT& freeze_ratio,
+                              const int nb_levels,
+                              const int smoothing_iterations)
+    : cdt_(cdt)
+    , convergence_ratio_(convergence_ratio)
+    , freeze_ratio_(freeze_ratio)
+    , nb_levels_(nb_levels)
+    , smoothing_iterations_(smoothing_iterations)
+    , time_limit_(0)
+    , seeds_mark_(false)
+    , stop_ptr_(0)
+    , os_(&std::cout)
+    , update_policy_(VERTEX_BY_VERTEX_MOVES)
+    , active_set_(false)
+    , relaxation_(1)
+    , anderson_window_(0)
+    , lbfgs_memory_(0)
+  {
+  }
+
+  /// Settings of the optimizers, see Mesh_global_optimizer_2. The time
+  /// limit covers all levels.
+  void set_time_limit(double time) { time_limit_ = time; }
+  void set_stop_pointer(std::atomic<bool>* stop_ptr) { stop_ptr_ = stop_ptr; }
+  void set_output_stream(std::ostream* os) { os_ = os ? os : &std::cout; }
+  void set_update_policy(Move_update_policy policy) { update_policy_ = policy; }
+  void set_active_set(bool active_set) { active_set_ = active_set; }
+  void set_relaxation(const FT& relaxation) { relaxation_ = relaxation; }
+  void set_anderson_window(std::size_t window) { anderson_window_ = window; }
+  void set_lbfgs_memory(std::size_t memory) { lbfgs_memory_ = memory; }
+
+  template<typename InputIterator>
+  void set_seeds(InputIterator b,
+                 InputIterator e,
+                 const bool mark = false)
+  {
+    seeds_.clear();
+    std::copy(b, e, std::back_inserter(seeds_));
+    seeds_mark_ = mark;
+  }
+
+  /// Runs at most \c nb_iterations iterations on the coarsest level, and
+  /// again at most \c nb_iterations on the triangulation: the coarse
+  /// iterations are cheap, and the triangulation is not held back by them.
+  /// In all, up to twice \c nb_iterations plus the smoothing iterations may
+  /// run; the time limit bounds all levels together.
+  Mesh_optimization_return_code operator()(const int nb_iterations)
+  {
+    running_time_.reset();
+    running_time_.start();
+
+    build_levels();
+    if ( levels_.empty() )
+    {
+      typename Optimizer<CDT>::type optimizer(cdt_, convergence_ratio_,
+                                              freeze_ratio_);
+      return run(optimizer, nb_iterations);
+    }
+
+    // From the coarsest level to the triangulation. members_[j] and
+    // levels_[j-1] are level j, level 0 is the triangulation.
+    positions_ = points_;
+    const std::size_t top = levels_.size();
+    for(std::size_t j = top ; j > 0 ; --j)
+    {
+      if ( is_time_limit_reached() )
+        break;
+
+      Level_tr& tr = *levels_[j - 1];
+      if ( j < top )
+      {
+        prolongate(j);
+        build_level(tr, members_[j]);
+      }
+
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+      (*os_) << "level=" << j << ";"
+             << "vertices=" << tr.number_of_vertices() << std::endl;
+#endif
+      typename Optimizer<Level_tr>::type optimizer(tr, convergence_ratio_,
+                                                   freeze_ratio_);
+      for(typename Level_tr::Finite_vertices_iterator
+            vit = tr.finite_vertices_begin() ;
+          vit != tr.finite_vertices_end() ;
+          ++vit )
+        vit->set_sizing_info(sizes_[vit->info()]);
+      run(optimizer, j == top ? nb_iterations : smoothing_iterations_);
+
+      // the triangulation is left as it was
+      if ( forced_stop() )
+        return CONVERGENCE_REACHED;
+
+      for(typename Level_tr::Finite_vertices_iterator
+            vit = tr.finite_vertices_begin() ;
+          vit != tr.finite_vertices_end() ;
+          ++vit )
+        positions_[vit->info()] = vit->point();
+    }
+
+    prolongate(0);
+    rebuild_triangulation();
+    levels_.clear();
+
+    if ( is_time_limit_reached() )
+      return TIME_LIMIT_REACHED;
+
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+    (*os_) << "level=0;"
+           << "vertices=" << cdt_.number_of_vertices() << std::endl;
+#endif
+    typename Optimizer<CDT>::type optimizer(cdt_, convergence_ratio_,
+                                            freeze_ratio_);
+    for(std::size_t i = 0 ; i < vertices_.size() ; ++i)
+      vertices_[i]->set_sizing_info(sizes_[i]);
+    return run(optimizer, nb_iterations);
+  }
+
+private:
+  /**
+   * Indexes the vertices of the triangulation, selects the vertices of
+   * each level and builds their triangulations, and locates the vertices
+   * missing from each level in the next one
+   */
+  void build_levels()
+  {
+    vertices_.clear();
+    points_.clear();
+    sizes_.clear();
+    members_.clear();
+    levels_.clear();
+    prolongations_.clear();
+    constrained_edges_.clear();
+    if ( nb_levels_ < 2 || cdt_.dimension() < 2 )
+      return;
+
+    // the sizing field of the triangulation, for all levels
+    typename Optimizer<CDT>::Sizing sizing(cdt_);
+
+    Unique_hash_map<Vertex_handle, std::size_t> indices;
+    for(typename CDT::Finite_vertices_iterator
+          vit = cdt_.finite_vertices_begin() ;
+        vit != cdt_.finite_vertices_end() ;
+        ++vit )
+    {
+      indices[vit] = vertices_.size();
+      vertices_.push_back(vit);
+      points_.push_back(vit->point());
+      sizes_.push_back(vit->sizing_info());
+    }
+    const std::size_t n = vertices_.size();
+
+    // The vertices of the constrained edges and of the convex hull are in
+    // all levels
+    fixed_.assign(n, 0);
+    for(typename CDT::Finite_edges_iterator eit = cdt_.finite_edges_begin() ;
+        eit != cdt_.finite_edges_end() ;
+        ++eit )
+    {
+      const std::size_t a = indices[eit->first->vertex(cdt_.cw(eit->second))];
+      const std::size_t b = indices[eit->first->vertex(cdt_.ccw(eit->second))];
+      if ( cdt_.is_constrained(*eit) )
+        constrained_edges_.push_back(Index_edge(a, b));
+      if ( cdt_.is_constrained(*eit) || cdt_.is_infinite(eit->first)
+        || cdt_.is_infinite(eit->first->neighbor(eit->second)) )
+        fixed_[a] = fixed_[b] = 1;
+    }
+
+    members_.push_back(Index_vector());
+    for(std::size_t i = 0 ; i < n ; ++i)
+      members_.back().push_back(i);
+
+    for(int j = 1 ; j < nb_levels_ ; ++j)
+    {
+      Index_vector selected;
+      if ( j == 1 )
+        select_independent_set(cdt_, Vertex_index{indices}, selected);
+      else
+        select_independent_set(*levels_.back(), Info_index(), selected);
+      if ( selected.size() < min_level_size )
+        break;
+
+      levels_.push_back(std::unique_ptr<Level_tr>(new Level_tr()));
+      members_.push_back(selected);
+      positions_ = points_;
+      build_level(*levels_.back(), selected);
+      locate_in_level(*levels_.back(), members_[j - 1]);
+    }
+  }
+
+  /**
+   * Puts in \c selected the fixed vertices of \c tr and a maximal set of
+   * other vertices of \c tr, no two of them adjacent in \c tr. Vertices
+   * are visited in the order of \c tr.
+   */
+  template <typename Tr, typename IndexMap>
+  void select_independent_set(const Tr& tr,
+                              const IndexMap& index,
+                              Index_vector& selected) const
+  {
+    std::vector<char> in_level(vertices_.size(), 0);
+    for(typename Tr::Finite_vertices_iterator vit = tr.finite_vertices_begin() ;
+        vit != tr.finite_vertices_end() ;
+        ++vit )
+    {
+      const std::size_t i = index(vit);
+      if ( fixed_[i] )
+        in_level[i] = 1;
+    }
+
+    for(typename Tr::Finite_vertices_iterator vit = tr.finite_vertices_begin() ;
+        vit != tr.finite_vertices_end() ;
+        ++vit )
+    {
+      const std::size_t i = index(vit);
+      if ( in_level[i] )
+        continue;
+      bool free = true;
+      typename Tr::Vertex_circulator vc = tr.incident_vertices(vit), done(vc);
+      do {
+        if ( !tr.is_infinite(vc) && in_level[index(vc)] )
+          free = false;
+      } while(free && ++vc != done);
+      if ( free )
+        in_level[i] = 1;
+    }
+
+    selected.clear();
+    for(std::size_t i = 0 ; i < in_level.size() ; ++i)
+      if ( in_level[i] )
+        selected.push_back(i);
+  }
+
+  /// Triangulates the vertices \c members at \c positions_
+  void build_level(Level_tr& tr, const Index_vector& members)
+  {
+    separate_duplicates(members);
+    tr.clear();
+    std::vector<std::pair<Point_2, std::size_t> > points;
+    points.reserve(members.size());
+    for(std::size_t k = 0 ; k < members.size() ; ++k)
+      points.push_back(std::make_pair(positions_[members[k]], members[k]));
+    tr.insert(points.begin(), points.end());
+    CGAL_assertion(tr.number_of_vertices() == members.size());
+
+    std::vector<typename Level_tr::Vertex_handle> handles(vertices_.size());
+    for(typename Level_tr::Finite_vertices_iterator
+          vit = tr.finite_vertices_begin() ;
+        vit != tr.finite_vertices_end() ;
+        ++vit )
+      handles[vit->info()] = vit;
+    for(typename std::vector<Index_edge>::const_iterator
+          it = constrained_edges_.begin() ;
+        it != constrained_edges_.end() ;
+        ++it )
+      tr.insert_constraint(handles[it->first], handles[it->second]);
+  }
+
+  /**
+   * Locates the vertices of \c members missing from \c tr in \c tr, and
+   * stores their barycentric coordinates
+   */
+  void locate_in_level(const Level_tr& tr, const Index_vector& members)
+  {
+    typename Gt::Compute_area_2 area = tr.geom_traits().compute_area_2_object();
+
+    std::vector<char> in_level(vertices_.size(), 0);
+    for(typename Level_tr::Finite_vertices_iterator
+          vit = tr.finite_vertices_begin() ;
+        vit != tr.finite_vertices_end() ;
+        ++vit )
+      in_level[vit->info()] = 1;
+
+    prolongations_.push_back(Prolongation_vector());
+    Prolongation_vector& prolongations = prolongations_.back();
+    typename Level_tr::Face_handle hint;
+    for(std::size_t k = 0 ; k < members.size() ; ++k)
+    {
+      const std::size_t i = members[k];
+      if ( in_level[i] )
+        continue;
+
+      Prolongation pr;
+      pr.vertex = i;
+      const Point_2& p = points_[i];
+      hint = tr.locate(p, hint);
+      if ( tr.is_infinite(hint) )
+      {
+        // cannot happen with the convex hull in all levels, stay in place
+        pr.face_vertices[0] = pr.face_vertices[1] = pr.face_vertices[2] = i;
+        pr.weights[0] = 1;
+        pr.weights[1] = pr.weights[2] = 0;
+      }
+      else
+      {
+        const Point_2& a = hint->vertex(0)->point();
+        const Point_2& b = hint->vertex(1)->point();
+        const Point_2& c = hint->vertex(2)->point();
+        const FT abc = area(a, b, c);
+        pr.weights[0] = area(p, b, c) / abc;
+        pr.weights[1] = area(a, p, c) / abc;
+        pr.weights[2] = 1 - pr.weights[0] - pr.weights[1];
+        for(int v = 0 ; v < 3 ; ++v)
+          pr.face_vertices[v] = hint->vertex(v)->info();
+      }
+      prolongations.push_back(pr);
+    }
+  }
+
+  /**
+   * Sets the positions of the vertices of level \c j missing from level \c
+   * j+1 from the positions of the vertices of their face in level \c j+1.
+   * The face must not be inverted, and the interpolated point must lie
+   * inside a face of the domain of level \c j+1, which has the same
+   * constraints as the triangulation: otherwise the vertex keeps its
+   * position.
+   */
+  void prolongate(std::size_t j)
+  {
+    typename Gt::Orientation_2 orientation =
+      cdt_.geom_traits().orientation_2_object();
+
+    Level_tr& tr = *levels_[j];
+    typedef CGAL::Delaunay_mesh_size_criteria_2<Level_tr> Criteria;
+    CGAL::Delaunay_mesher_2<Level_tr, Criteria>::mark_facets(tr,
+      seeds_.begin(), seeds_.end(), seeds_mark_);
+
+    typename Level_tr::Face_handle hint;
+    typename Level_tr::Locate_type lt;
+    int li;
+    const Prolongation_vector& prolongations = prolongations_[j];
+    for(typename Prolongation_vector::const_iterator it = prolongations.begin() ;
+        it != prolongations.end() ;
+        ++it )
+    {
+      const Point_2& a = positions_[it->face_vertices[0]];
+      const Point_2& b = positions_[it->face_vertices[1]];
+      const Point_2& c = positions_[it->face_vertices[2]];
+      if ( orientation(a, b, c) != LEFT_TURN )
+        continue;
+      const Point_2 p =
+        a + (it->weights[1] * (b - a) + it->weights[2] * (c - a));
+      // on an edge, p could split a constraint
+      hint = tr.locate(p, lt, li, hint);
+      if ( lt != Level_tr::FACE || !hint->is_in_domain() )
+        continue;
+      positions_[it->vertex] = p;
+    }
+  }
+
+  /**
+   * Puts back at their initial point the vertices of \c members whose
+   * position is the position of another one, so that none is lost when
+   * they are inserted. In each group of vertices at the same position, a
+   * vertex at its initial point, if any, keeps it. The initial points are
+   * distinct, so each round puts back at least one vertex for good.
+   */
+  void separate_duplicates(const Index_vector& members)
+  {
+    typename Gt::Less_xy_2 less_xy = cdt_.geom_traits().less_xy_2_object();
+    typename Gt::Equal_2 equal = cdt_.geom_traits().equal_2_object();
+
+    Index_vector order(members);
+    bool moved = true;
+    while ( moved )
+    {
+      moved = false;
+      std::sort(order.begin(), order.end(),
+        [&](std::size_t a, std::size_t b)
+        { return less_xy(positions_[a], positions_[b]); });
+      for(std::size_t first = 0, last = 0 ; first < order.size() ; first = last)
+      {
+        std::size_t keep = order[first];
+        for(last = first + 1 ;
+            last < order.size()
+              && equal(positions_[order[last]], positions_[order[first]]) ;
+            ++last )
+          if ( equal(positions_[order[last]], points_[order[last]]) )
+            keep = order[last];
+        for(std::size_t k = first ; k < last ; ++k)
+        {
+          if ( order[k] == keep )
+            continue;
+          positions_[order[k]] = points_[order[k]];
+          moved = true;
+        }
+      }
+    }
+  }
+
+  /**
+   * Rebuilds the triangulation with its vertices at \c positions_, keeping
+   * their data
+   */
+  void rebuild_triangulation()
+  {
+    separate_duplicates(members_[0]);
+    const std::size_t n = vertices_.size();
+    std::vector<Vertex_data> data;
+    data.reserve(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      data.push_back(Vertex_data(*vertices_[i]));
+
+    Index_vector order;
+    order.reserve(n);
+    for(std::size_t i = 0 ; i < n ; ++i)
+      order.push_back(i);
+    typedef typename Pointer_property_map<Point_2>::type Pmap;
+    typedef Spatial_sort_traits_adapter_2<Gt,Pmap> Search_traits;
+    CGAL::hilbert_sort(order.begin(), order.end(),
+                       Search_traits(make_property_map(positions_),
+                                     cdt_.geom_traits()));
+
+    cdt_.clear();
+    typename CDT::Face_handle hint;
+    for(std::size_t k = 0 ; k < n ; ++k)
+    {
+      const std::size_t i = order[k];
+      vertices_[i] = cdt_.insert(positions_[i], hint);
+      hint = vertices_[i]->face();
+      data[i].restore(*vertices_[i]);
+    }
+    CGAL_assertion(cdt_.number_of_vertices() == n);
+    for(typename std::vector<Index_edge>::const_iterator
+          it = constrained_edges_.begin() ;
+        it != constrained_edges_.end() ;
+        ++it )
+      cdt_.insert_constraint(vertices_[it->first], vertices_[it->second]);
+  }
+
+  template <typename Optimizer_>
+  Mesh_optimization_return_code run(Optimizer_& optimizer,
+                                    const int nb_iterations)
+  {
+    optimizer.set_time_limit(time_limit_ > 0
+      ? (std::max)(time_limit_ - running_time_.time(), 1e-6) : 0.);
+    optimizer.set_seeds(seeds_.begin(), seeds_.end(), seeds_mark_);
+    optimizer.set_stop_pointer(stop_ptr_);
+    optimizer.set_output_stream(os_);
+    optimizer.set_update_policy(update_policy_);
+    optimizer.set_active_set(active_set_);
+    optimizer.set_relaxation(relaxation_);
+    optimizer.set_anderson_window(anderson_window_);
+    optimizer.set_lbfgs_memory(lbfgs_memory_);
+    return optimizer(nb_iterations);
+  }
+
+  bool forced_stop() const
+  {
+    return stop_ptr_ != 0
+        && stop_ptr_->load(std::memory_order_acquire);
+  }
+
+  bool is_time_limit_reached() const
+  {
+    return (time_limit_ > 0)
+        && (running_time_.time() > time_limit_);
+  }
+
+private:
+  CDT& cdt_;
+  FT convergence_ratio_;
+  FT freeze_ratio_;
+  int nb_levels_;
+  int smoothing_iterations_;
+
+  double time_limit_;
+  CGAL::Real_timer running_time_;
+  std::list<Point_2> seeds_;
+  bool seeds_mark_;
+  std::atomic<bool>* stop_ptr_;
+  std::ostream* os_;
+  Move_update_policy update_policy_;
+  bool active_set_;
+  FT relaxation_;
+  std::size_t anderson_window_;
+  std::size_t lbfgs_memory_;
+
+  // The vertices of the triangulation with their initial points and sizes,
+  // by index
+  std::vector<Vertex_handle> vertices_;
+  std::vector<Point_2> points_;
+  std::vector<FT> sizes_;
+  std::vector<char> fixed_;
+  std::vector<Index_edge> constrained_edges_;
+  // Current points of the vertices of the levels optimized so far
+  std::vector<Point_2> positions_;
+  // The vertices of each level, from the triangulation up
+  std::vector<Index_vector> members_;
+  // Triangulations of the levels above the triangulation
+  std::vector<std::unique_ptr<Level_tr> > levels_;
+  // How each level gets the positions of its vertices from the next one
+  std::vector<Prolongation_vector> prolongations_;
+};
+
+} // end namespace Mesh_2
+
+} // end namespace CGAL
+
+#endif // CGAL_MESH_2_MESH_MULTILEVEL_OPTIMIZER_2_H
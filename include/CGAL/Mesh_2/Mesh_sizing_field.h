@@ -20,17 +20,73 @@
 
 #include <CGAL/Mesh_2/Sizing_field_2.h>
 #include <CGAL/squared_distance_2.h>
+#include <CGAL/tags.h>
+
+#ifdef CGAL_LINKED_WITH_TBB
+# include <tbb/enumerable_thread_specific.h>
+#endif
 
 namespace CGAL {
 
 namespace Mesh_2
 {
+
+/**
+ * @class Mesh_sizing_field_base_2
+ */
+// Sequential
+template <typename Face_handle, typename Concurrency_tag>
+class Mesh_sizing_field_base_2
+{
+protected:
+  Face_handle get_last_face() const
+  {
+    return last_face_;
+  }
+
+  void set_last_face(Face_handle f) const
+  {
+    last_face_ = f;
+  }
+
+private:
+  /// A face_handle that is used to accelerate location queries
+  mutable Face_handle last_face_;
+};
+
+#ifdef CGAL_LINKED_WITH_TBB
+/**
+ * @class Mesh_sizing_field_base_2 specialization
+ */
+// Parallel
+template <typename Face_handle>
+class Mesh_sizing_field_base_2<Face_handle, Parallel_tag>
+{
+protected:
+  Face_handle get_last_face() const
+  {
+    return last_face_.local();
+  }
+
+  void set_last_face(Face_handle f) const
+  {
+    last_face_.local() = f;
+  }
+
+private:
+  /// A face_handle per thread that is used to accelerate location queries
+  mutable tbb::enumerable_thread_specific<Face_handle> last_face_;
+};
+#endif // CGAL_LINKED_WITH_TBB
+
 /**
  * @class Mesh_sizing_field
  */
-template <typename Tr, bool Need_vertex_update = true>
+template <typename Tr, bool Need_vertex_update = true,
+          typename Concurrency_tag = Sequential_tag>
 class Mesh_sizing_field
   : public virtual Sizing_field_2<Tr>
+  , public Mesh_sizing_field_base_2<typename Tr::Face_handle, Concurrency_tag>
 {
   // Types
   typedef typename Tr::Geom_traits   Gt;
@@ -51,7 +107,6 @@ public:
    */
   Mesh_sizing_field(Tr& tr)
   : tr_(tr)
-  , last_face_()
   {
     init();
   }
@@ -60,7 +115,7 @@ public:
    * Returns size at point \c p.
    */
   FT operator()(const Point_2& p) const
-  { return this->operator()(p, last_face_); }
+  { return this->operator()(p, this->get_last_face()); }
 
   /**
    * Returns size at point \c p, using \c v to accelerate \c p location
@@ -75,7 +130,7 @@ public:
   FT operator()(const Point_2& p, const Face_handle& c) const
   {
     const Face_handle fh = tr_.locate(p,c);
-    last_face_ = fh;
+    this->set_last_face(fh);
 
     if ( !tr_.is_infinite(fh) )
       return interpolate_on_face_vertices(p,fh);
@@ -203,8 +258,6 @@ private:
 private:
   /// The triangulation
   Tr& tr_;
-  /// A face_handle that is used to accelerate location queries
-  mutable Face_handle last_face_;
 };
 
 } // end namespace Mesh_2
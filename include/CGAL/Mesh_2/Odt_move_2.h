@@ -0,0 +1,163 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// Optimal Delaunay triangulation move of Mesh_global_optimizer_2, after
+// Mesh_3/Odt_move.h.
+
+
+#ifndef CGAL_MESH_2_ODT_MOVE_2_H
+#define CGAL_MESH_2_ODT_MOVE_2_H
+
+#include <CGAL/license/Mesh_2.h>
+
+#include <CGAL/Mesh_2/Uniform_sizing_field_2.h>
+#include <CGAL/Delaunay_mesh_face_base_with_circumcenter_2.h>
+
+#include <algorithm>
+#include <string>
+
+namespace CGAL
+{
+namespace Mesh_2
+{
+  /**
+   * Moves a vertex to the average of the circumcenters of its incident
+   * faces, weighted by their areas over the squared size at their
+   * centroids. Unlike Lloyd_move_2, no Voronoi cell is built: the faces
+   * around the vertex and their (cached) circumcenters are enough.
+   *
+   * The circumcenters of faces next to the boundary of the domain may lie
+   * far outside it, so the move stops halfway to the first incident face
+   * it would flatten: the vertex stays inside its star, on the side of
+   * the constraints it started from. Vertices of constrained edges and of
+   * the convex hull do not move.
+   */
+  template<typename CDT,
+           typename SizingField
+           = Uniform_sizing_field_2<typename CDT::Geom_traits> >
+  class Odt_move_2
+  {
+    typedef typename CDT::Vertex_handle           Vertex_handle;
+    typedef typename CDT::Face_circulator         Face_circulator;
+    typedef typename CDT::Geom_traits::Point_2    Point_2;
+    typedef typename CDT::Geom_traits::FT         FT;
+    typedef typename CDT::Geom_traits::Vector_2   Vector_2;
+
+  public:
+    typedef SizingField Sizing_field;
+
+  public:
+    Vector_2 operator()(Vertex_handle v,
+          const CDT& cdt,
+          const Sizing_field& sizing_field = Sizing_field()) const
+    {
+      if(cdt.are_there_incident_constraints(v))
+        return CGAL::NULL_VECTOR;
+
+      const Point_2& p = v->point();
+      Vector_2 move = CGAL::NULL_VECTOR;
+      FT sum_masses(0);
+
+      typename CDT::Geom_traits::Compute_area_2 compute_area =
+        cdt.geom_traits().compute_area_2_object();
+      typename CDT::Geom_traits::Construct_centroid_2 centroid =
+        cdt.geom_traits().construct_centroid_2_object();
+
+      Face_circulator fc = cdt.incident_faces(v), done(fc);
+      if(fc == 0)
+        return CGAL::NULL_VECTOR;
+      do
+      {
+        // the optimal position on the convex hull is unbounded
+        if(cdt.is_infinite(fc))
+          return CGAL::NULL_VECTOR;
+
+        const Point_2& a = fc->vertex(0)->point();
+        const Point_2& b = fc->vertex(1)->point();
+        const Point_2& c = fc->vertex(2)->point();
+        const Point_2 circumcenter = internal::face_circumcenter(cdt, fc);
+
+        // Compute mass
+        FT density = density_2d(centroid(a, b, c), v, sizing_field);
+        FT abs_area = CGAL::abs(compute_area(a, b, c));
+        FT mass = abs_area * density;
+
+        move = move + mass * Vector_2(p, circumcenter);
+        sum_masses += mass;
+      }
+      while(++fc != done);
+
+      if(sum_masses == FT(0))
+        return CGAL::NULL_VECTOR;
+      move = move / sum_masses;
+      return star_step(v, move, cdt) * move;
+    }
+
+  private:
+    // Fraction of move that keeps v inside its star: 1, or half the
+    // fraction that flattens the first incident face
+    FT star_step(const Vertex_handle& v,
+                 const Vector_2& move,
+                 const CDT& cdt) const
+    {
+      const Point_2& p = v->point();
+      FT step(1);
+      Face_circulator fc = cdt.incident_faces(v), done(fc);
+      do
+      {
+        const int i = fc->index(v);
+        const Point_2& a = fc->vertex(cdt.ccw(i))->point();
+        const Point_2& b = fc->vertex(cdt.cw(i))->point();
+        // twice the area of (p + t move, a, b) is
+        // twice_area + t * shrink, with twice_area > 0
+        const Vector_2 ab(a, b);
+        const Vector_2 pa(p, a);
+        const Vector_2 pb(p, b);
+        const FT twice_area = pa.x() * pb.y() - pa.y() * pb.x();
+        const FT shrink = ab.x() * move.y() - ab.y() * move.x();
+        if(shrink < 0)
+          step = (std::min)(step, twice_area / (-2 * shrink));
+      }
+      while(++fc != done);
+      return (std::max)(step, FT(0));
+    }
+
+    FT density_2d(const Point_2& p,
+                  const Vertex_handle& v,
+                  const Sizing_field& sizing_field) const
+    {
+      FT s = size_at(p, v, sizing_field, 0);
+      CGAL_assertion( s > 0. );
+
+      // 1 / s^d
+      return ( 1/(s*s) );
+    }
+
+    // See Lloyd_move_2
+    template <typename SF>
+    static auto size_at(const Point_2& p, const Vertex_handle& v,
+                        const SF& sizing_field, int)
+      -> decltype(sizing_field(p, v))
+    {
+      return sizing_field(p, v);
+    }
+
+    template <typename SF>
+    static FT size_at(const Point_2& p, const Vertex_handle&,
+                      const SF& sizing_field, long)
+    {
+      return sizing_field(p);
+    }
+
+#ifdef CGAL_MESH_2_OPTIMIZER_VERBOSE
+  public:
+    static std::string name() { return std::string("Odt"); }
+#endif
+
+  };
+
+} //end namespace Mesh_2
+} //end namespace CGAL
+
+#endif //CGAL_MESH_2_ODT_MOVE_2_H
@@ -0,0 +1,160 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// The body shared by lloyd_optimize_mesh_2 and odt_optimize_mesh_2, which
+// only differ by their move.
+
+#ifndef CGAL_MESH_2_OPTIMIZE_MESH_2_IMPL_H
+#define CGAL_MESH_2_OPTIMIZE_MESH_2_IMPL_H
+
+#include <CGAL/license/Mesh_2.h>
+
+#include <CGAL/Mesh_2/Mesh_global_optimizer_2.h>
+#include <CGAL/Mesh_2/Mesh_multilevel_optimizer_2.h>
+#include <CGAL/Mesh_2/Mesh_sizing_field.h>
+#include <CGAL/Mesh_optimization_return_code.h>
+#include <CGAL/iterator.h>
+#include <CGAL/use.h>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <string>
+
+namespace CGAL
+{
+namespace Mesh_2
+{
+namespace internal
+{
+  /**
+  * Optimizes \c cdt with the move \c MoveFunction, instantiated with \c CDT
+  * and its Mesh_sizing_field. \c name prefixes the files of the angle
+  * histograms written with CGAL_MESH_2_OPTIMIZERS_DEBUG.
+  */
+  template<template <typename, typename> class MoveFunction,
+           typename CDT, typename InputIterator, typename ConcurrencyTag>
+  Mesh_optimization_return_code
+  optimize_mesh_2_impl(const char* name,
+                       CDT& cdt,
+                       const int max_iterations,
+                       const double convergence_ratio,
+                       const double freeze_bound,
+                       const double time_limit,
+                       InputIterator seeds_begin,
+                       InputIterator seeds_end,
+                       const bool mark,
+                       std::atomic<bool>* stop_ptr,
+                       std::ostream* output_stream,
+                       ConcurrencyTag,
+                       const Move_update_policy update_policy,
+                       const bool active_set,
+                       const double relaxation,
+                       const int anderson_window,
+                       const int nb_levels,
+                       const int smoothing_iterations,
+                       const int lbfgs_memory)
+  {
+    typedef Mesh_sizing_field<CDT, true, ConcurrencyTag>       Sizing;
+    typedef MoveFunction<CDT, Sizing>                          Mv;
+    typedef Mesh_global_optimizer_2<CDT, Mv, ConcurrencyTag>   Optimizer;
+
+    if ( nb_levels > 1 )
+    {
+      Mesh_multilevel_optimizer_2<CDT, MoveFunction, ConcurrencyTag>
+        multilevel(cdt, convergence_ratio, freeze_bound, nb_levels,
+                   smoothing_iterations);
+      multilevel.set_time_limit(time_limit);
+      multilevel.set_seeds(seeds_begin, seeds_end, mark);
+      multilevel.set_stop_pointer(stop_ptr);
+      multilevel.set_output_stream(output_stream);
+      multilevel.set_update_policy(update_policy);
+      multilevel.set_active_set(active_set);
+      multilevel.set_relaxation(relaxation);
+      multilevel.set_anderson_window(anderson_window);
+      multilevel.set_lbfgs_memory(lbfgs_memory);
+      return multilevel(max_iterations);
+    }
+
+    Optimizer optimizer(cdt,
+                        convergence_ratio,
+                        freeze_bound);
+    optimizer.set_time_limit(time_limit);
+    optimizer.set_seeds(seeds_begin, seeds_end, mark);
+    optimizer.set_stop_pointer(stop_ptr);
+    optimizer.set_output_stream(output_stream);
+    optimizer.set_update_policy(update_policy);
+    optimizer.set_active_set(active_set);
+    optimizer.set_relaxation(relaxation);
+    optimizer.set_anderson_window(anderson_window);
+    optimizer.set_lbfgs_memory(lbfgs_memory);
+
+#ifdef CGAL_MESH_2_OPTIMIZERS_DEBUG
+    std::ofstream os("before_" + std::string(name) + ".angles.txt");
+    optimizer.output_angles_histogram(os);
+    os.close();
+#else
+    CGAL_USE(name);
+#endif
+
+    int nb_iterations = max_iterations;
+
+    //run optimization
+    Mesh_optimization_return_code rc = optimizer(nb_iterations);
+
+#ifdef CGAL_MESH_2_OPTIMIZERS_DEBUG
+    std::ofstream os2("after_" + std::string(name) + ".angles.txt");
+    optimizer.output_angles_histogram(os2);
+    os2.close();
+#endif
+
+    return rc;
+  }
+
+  /**
+  * this partial specialization is a workaround
+  * to avoid compilation errors when seeds_begin and seeds_end are
+  * not initialized. Indeed, there is no way to have a
+  * "default empty iterator" for these named parameters.
+  * Emptyset_iterator implements OutputIterator,
+  * but stands here for "any empty input iterator"
+  * (and any other type could).
+  */
+  template<template <typename, typename> class MoveFunction,
+           typename CDT, typename ConcurrencyTag>
+  Mesh_optimization_return_code
+  optimize_mesh_2_impl(const char* name,
+                       CDT& cdt,
+                       const int max_iterations,
+                       const double convergence_ratio,
+                       const double freeze_bound,
+                       const double time_limit,
+                       CGAL::Emptyset_iterator,
+                       CGAL::Emptyset_iterator,
+                       const bool mark,
+                       std::atomic<bool>* stop_ptr,
+                       std::ostream* output_stream,
+                       ConcurrencyTag concurrency_tag,
+                       const Move_update_policy update_policy,
+                       const bool active_set,
+                       const double relaxation,
+                       const int anderson_window,
+                       const int nb_levels,
+                       const int smoothing_iterations,
+                       const int lbfgs_memory)
+  {
+    std::list<typename CDT::Point> seeds;
+    return optimize_mesh_2_impl<MoveFunction>(name, cdt, max_iterations,
+      convergence_ratio, freeze_bound, time_limit, seeds.begin(), seeds.end(),
+      mark, stop_ptr, output_stream, concurrency_tag, update_policy,
+      active_set, relaxation, anderson_window, nb_levels,
+      smoothing_iterations, lbfgs_memory);
+  }
+
+} // end namespace internal
+} // end namespace Mesh_2
+} // end namespace CGAL
+
+#endif // CGAL_MESH_2_OPTIMIZE_MESH_2_IMPL_H
@@ -0,0 +1,256 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// Parallel restoration of the constrained Delaunay property by edge flips,
+// used by Constrained_Delaunay_triangulation_2::restore_Delaunay.
+
+
+#ifndef CGAL_TRIANGULATION_2_INTERNAL_PARALLEL_FLIPS_2_H
+#define CGAL_TRIANGULATION_2_INTERNAL_PARALLEL_FLIPS_2_H
+
+#include <CGAL/license/Triangulation_2.h>
+
+#ifdef CGAL_LINKED_WITH_TBB
+
+#include <CGAL/Bbox_2.h>
+#include <CGAL/Spatial_lock_grid_2.h>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for_each.h>
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace CGAL {
+
+namespace internal {
+
+// Flips the non Delaunay edges around a set of vertices whose points changed
+// in place, with several threads.
+//
+// Flipping edge (f,i) changes the faces f and f->neighbor(i), the neighbor
+// pointers of the four faces around them and the faces of the four vertices
+// of the quadrilateral. A face adjacent to the quadrilateral shares two of
+// these vertices, so locking the cells of the four vertices in a
+// Spatial_lock_grid_2 keeps any other flip away from everything the flip
+// touches. A thread that cannot get a lock puts the edge back as a new task.
+//
+// The constrained Delaunay triangulation is unique (is_flipable breaks ties
+// with a symbolic perturbation), so the result does not depend on the order
+// in which the threads flip.
+template <class CDT>
+class Cdt_2_parallel_flips
+{
+  typedef typename CDT::Vertex_handle   Vertex_handle;
+  typedef typename CDT::Face_handle     Face_handle;
+  typedef typename CDT::Edge            Edge;
+  typedef typename CDT::Face_circulator Face_circulator;
+
+  typedef Spatial_lock_grid_2<Tag_priority_blocking> Lock_grid;
+  typedef std::vector<Edge>                          Edge_vector;
+  typedef std::vector<Face_handle>                   Face_vector;
+
+  // Number of seed edges given to a task
+  static const std::size_t seeds_per_task = 256;
+
+public:
+  Cdt_2_parallel_flips(CDT& cdt)
+    : cdt_(cdt)
+    , local_new_faces_(0)
+  {}
+
+  // Returns the number of flips
+  template <class VertexIterator>
+  std::size_t operator()(VertexIterator first, VertexIterator last)
+  {
+    return flip_all(first, last);
+  }
+
+  // Same as above, and outputs the two faces created by each flip
+  template <class VertexIterator, class OutputItFaces>
+  std::size_t operator()(VertexIterator first, VertexIterator last,
+                         OutputItFaces& out)
+  {
+    tbb::enumerable_thread_specific<Face_vector> local_new_faces;
+    local_new_faces_ = &local_new_faces;
+    const std::size_t nb_flips = flip_all(first, last);
+    local_new_faces_ = 0;
+
+    for(typename tbb::enumerable_thread_specific<Face_vector>::const_iterator
+          it = local_new_faces.begin(); it != local_new_faces.end(); ++it)
+      out = std::copy(it->begin(), it->end(), out);
+    return nb_flips;
+  }
+
+private:
+  template <class VertexIterator>
+  std::size_t flip_all(VertexIterator first, VertexIterator last)
+  {
+    if(first == last || cdt_.dimension() < 2)
+      return 0;
+
+    // Read only: the flippable edges of the stars of the vertices
+    tbb::enumerable_thread_specific<Edge_vector> local_seeds;
+    tbb::enumerable_thread_specific<Bbox_2> local_bboxes;
+    tbb::parallel_for_each(first, last, [&](const Vertex_handle& v)
+    {
+      local_bboxes.local() += v->point().bbox();
+      Edge_vector& seeds = local_seeds.local();
+      Face_circulator fc = cdt_.incident_faces(v), done(fc);
+      do {
+        int i = fc->index(v);
+        if(cdt_.is_flipable(fc, i))
+          seeds.push_back(Edge(fc, i));
+        if(cdt_.is_flipable(fc, cdt_.cw(i)))
+          seeds.push_back(Edge(fc, cdt_.cw(i)));
+      } while(++fc != done);
+    });
+
+    Bbox_2 bbox;
+    std::size_t nb_seeds = 0;
+    for(typename tbb::enumerable_thread_specific<Bbox_2>::const_iterator
+          it = local_bboxes.begin(); it != local_bboxes.end(); ++it)
+      bbox += *it;
+    for(typename tbb::enumerable_thread_specific<Edge_vector>::const_iterator
+          it = local_seeds.begin(); it != local_seeds.end(); ++it)
+      nb_seeds += it->size();
+    if(nb_seeds == 0)
+      return 0;
+
+    // About 16 vertices per cell, so that most flips lock few cells
+    const double nb_vertices =
+      static_cast<double>(std::distance(first, last));
+    const int cells_per_axis = (std::max)(1, (std::min)(1024,
+      static_cast<int>(std::sqrt(nb_vertices / 16.))));
+    if(bbox.xmax() <= bbox.xmin() || bbox.ymax() <= bbox.ymin())
+      bbox = Bbox_2(bbox.xmin() - 1, bbox.ymin() - 1,
+                    bbox.xmax() + 1, bbox.ymax() + 1);
+    Lock_grid lock_grid(bbox, cells_per_axis);
+    lock_grid_ = &lock_grid;
+
+    // Flip, each task draining the edges its flips make suspect
+    tbb::enumerable_thread_specific<std::size_t> local_flips(0);
+    local_flips_ = &local_flips;
+    for(typename tbb::enumerable_thread_specific<Edge_vector>::const_iterator
+          it = local_seeds.begin(); it != local_seeds.end(); ++it)
+    {
+      for(std::size_t b = 0; b < it->size(); b += seeds_per_task)
+      {
+        const Edge* begin = it->data() + b;
+        const Edge* end = it->data() + (std::min)(b + seeds_per_task, it->size());
+        task_group_.run([this, begin, end]() { flip(begin, end); });
+      }
+    }
+    task_group_.wait();
+
+    std::size_t nb_flips = 0;
+    for(typename tbb::enumerable_thread_specific<std::size_t>::const_iterator
+          it = local_flips.begin(); it != local_flips.end(); ++it)
+      nb_flips += *it;
+    lock_grid_ = 0;
+    local_flips_ = 0;
+    return nb_flips;
+  }
+
+  void flip(const Edge* begin, const Edge* end)
+  {
+    Edge_vector edges(begin, end);
+    std::size_t& nb_flips = local_flips_->local();
+    while(!edges.empty())
+    {
+      Edge e = edges.back();
+      edges.pop_back();
+      if(!try_lock_and_flip(e, edges, nb_flips))
+      {
+        // Another thread works nearby, try again later
+        std::this_thread::yield();
+        task_group_.run([this, e]() { flip(&e, &e + 1); });
+      }
+    }
+  }
+
+  // Returns false if the edge could not be locked
+  bool try_lock_and_flip(const Edge& e, Edge_vector& edges,
+                         std::size_t& nb_flips)
+  {
+    Face_handle f = e.first;
+    const int i = e.second;
+    const Vertex_handle a = f->vertex(i);
+    const Vertex_handle b = f->vertex(cdt_.cw(i));
+    const Vertex_handle c = f->vertex(cdt_.ccw(i));
+
+    // Edges of infinite faces are never flipped
+    if(cdt_.is_infinite(a) || cdt_.is_infinite(b) || cdt_.is_infinite(c))
+      return true;
+
+    if(!lock_grid_->try_lock(a->point())
+      || !lock_grid_->try_lock(b->point())
+      || !lock_grid_->try_lock(c->point()))
+    {
+      lock_grid_->unlock_all_points_locked_by_this_thread();
+      return false;
+    }
+
+    // A flip changed f before it was locked. That flip made the remaining
+    // edges of f suspect, so this one needs no more work.
+    if(f->vertex(i) != a || f->vertex(cdt_.cw(i)) != b
+      || f->vertex(cdt_.ccw(i)) != c)
+    {
+      lock_grid_->unlock_all_points_locked_by_this_thread();
+      return true;
+    }
+
+    // The neighbor and its opposite vertex only change when an edge
+    // incident to b or c is flipped, which needs the locks held here
+    Face_handle n = f->neighbor(i);
+    const int mi = cdt_.mirror_index(f, i);
+    const Vertex_handle d = n->vertex(mi);
+    if(cdt_.is_infinite(d))
+    {
+      lock_grid_->unlock_all_points_locked_by_this_thread();
+      return true;
+    }
+    if(!lock_grid_->try_lock(d->point()))
+    {
+      lock_grid_->unlock_all_points_locked_by_this_thread();
+      return false;
+    }
+
+    if(cdt_.is_flipable(f, i))
+    {
+      cdt_.flip(f, i);
+      ++nb_flips;
+      if(local_new_faces_ != 0)
+      {
+        Face_vector& new_faces = local_new_faces_->local();
+        new_faces.push_back(f);
+        new_faces.push_back(n);
+      }
+      edges.push_back(Edge(f, i));
+      edges.push_back(Edge(f, cdt_.cw(i)));
+      edges.push_back(Edge(n, cdt_.cw(mi)));
+      edges.push_back(Edge(n, mi));
+    }
+    lock_grid_->unlock_all_points_locked_by_this_thread();
+    return true;
+  }
+
+  CDT& cdt_;
+  tbb::task_group task_group_;
+  Lock_grid* lock_grid_;
+  tbb::enumerable_thread_specific<std::size_t>* local_flips_;
+  tbb::enumerable_thread_specific<Face_vector>* local_new_faces_;
+};
+
+} // namespace internal
+
+} // namespace CGAL
+
+#endif // CGAL_LINKED_WITH_TBB
+
+#endif // CGAL_TRIANGULATION_2_INTERNAL_PARALLEL_FLIPS_2_H
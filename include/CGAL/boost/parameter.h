@@ -105,6 +105,15 @@ BOOST_PARAMETER_NAME( (maximal_number_of_vertices, tag ) maximal_number_of_verti
 BOOST_PARAMETER_NAME( (nonlinear_growth_of_balls, tag ) nonlinear_growth_of_balls_)
 BOOST_PARAMETER_NAME( (pointer_to_error_code, tag ) pointer_to_error_code_)
 BOOST_PARAMETER_NAME( (pointer_to_stop_atomic_boolean, tag ) pointer_to_stop_atomic_boolean_)
+BOOST_PARAMETER_NAME( (pointer_to_output_stream, tag ) pointer_to_output_stream_)
+BOOST_PARAMETER_NAME( (concurrency_tag, tag ) concurrency_tag_)
+BOOST_PARAMETER_NAME( (update_policy, tag ) update_policy_)
+BOOST_PARAMETER_NAME( (active_set, tag ) active_set_)
+BOOST_PARAMETER_NAME( (relaxation, tag ) relaxation_)
+BOOST_PARAMETER_NAME( (anderson_window, tag ) anderson_window_)
+BOOST_PARAMETER_NAME( (number_of_levels, tag ) number_of_levels_)
+BOOST_PARAMETER_NAME( (smoothing_iterations, tag ) smoothing_iterations_)
+BOOST_PARAMETER_NAME( (lbfgs_memory, tag ) lbfgs_memory_)
 
 // First used in <CGAL/Labeled_mesh_domain_3.h>
 BOOST_PARAMETER_NAME( (function, tag ) function_)
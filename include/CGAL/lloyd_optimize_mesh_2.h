@@ -17,15 +17,16 @@
 
 #include <CGAL/disable_warnings.h>
 
-#include <CGAL/Mesh_2/Mesh_global_optimizer_2.h>
+#include <CGAL/Mesh_2/optimize_mesh_2_impl.h>
 #include <CGAL/Mesh_2/Lloyd_move_2.h>
-#include <CGAL/Mesh_2/Mesh_sizing_field.h>
 #include <CGAL/Mesh_optimization_return_code.h>
 #include <CGAL/iterator.h>
+#include <CGAL/tags.h>
 #include <CGAL/boost/parameter.h>
 #include <boost/parameter/preprocessor.hpp>
 
-#include <fstream>
+#include <atomic>
+#include <iostream>
 
 // see <CGAL/config.h>
 CGAL_PRAGMA_DIAG_PUSH
@@ -51,92 +52,48 @@ namespace CGAL
     (convergence_, *, 0.001 )
     (time_limit_, *, 0. )
     (freeze_bound_, *, 0.001 )
-    (seeds_begin_, *, CGAL::Emptyset_iterator())//see comments below
-    (seeds_end_, *, CGAL::Emptyset_iterator())//see comments below
+    (seeds_begin_, *, CGAL::Emptyset_iterator())//see <CGAL/Mesh_2/optimize_mesh_2_impl.h>
+    (seeds_end_, *, CGAL::Emptyset_iterator())//see <CGAL/Mesh_2/optimize_mesh_2_impl.h>
     (mark_, *, false) //if "false", seeds indicate "outside" regions
+    (pointer_to_stop_atomic_boolean_, *, (std::atomic<bool>*)0)
+    (pointer_to_output_stream_, *, (std::ostream*)0)
+    (concurrency_tag_, *, CGAL::Sequential_tag())
+    (update_policy_, *, Mesh_2::VERTEX_BY_VERTEX_MOVES)
+    (active_set_, *, false)
+    (relaxation_, *, 1.)
+    (anderson_window_, *, 0)
+    (number_of_levels_, *, 1)
+    (smoothing_iterations_, *, 5)
+    (lbfgs_memory_, *, 0)
   )
   )
   {
-    return lloyd_optimize_mesh_2_impl(cdt,
-                                      max_iteration_number_,
-                                      convergence_,
-                                      freeze_bound_,
-                                      time_limit_,
-                                      seeds_begin_,
-                                      seeds_end_,
-                                      mark_);
+    return Mesh_2::internal::optimize_mesh_2_impl<Mesh_2::Lloyd_move_2>(
+      "lloyd",
+      cdt,
+      max_iteration_number_,
+      convergence_,
+      freeze_bound_,
+      time_limit_,
+      seeds_begin_,
+      seeds_end_,
+      mark_,
+      pointer_to_stop_atomic_boolean_,
+      pointer_to_output_stream_,
+      concurrency_tag_,
+      update_policy_,
+      active_set_,
+      relaxation_,
+      anderson_window_,
+      number_of_levels_,
+      smoothing_iterations_,
+      lbfgs_memory_);
   }
 
 #if defined(BOOST_MSVC)
 #  pragma warning(pop)
 #endif
 
-  /**
-  * this partial specialization is a workaround
-  * to avoid compilation errors when seeds_begin and seeds_end are
-  * not initialized. Indeed, there is no way to have a
-  * "default empty iterator" for these named parameters.
-  * Emptyset_iterator implements OutputIterator,
-  * but stands here for "any empty input iterator"
-  * (and any other type could).
-  */
-  template<typename CDT>
-  Mesh_optimization_return_code
-  lloyd_optimize_mesh_2_impl(CDT& cdt,
-                             const int max_iterations,
-                             const double convergence_ratio,
-                             const double freeze_bound,
-                             const double time_limit,
-                             CGAL::Emptyset_iterator,
-                             CGAL::Emptyset_iterator,
-                             const bool mark)
-  {
-    std::list<typename CDT::Point> seeds;
-    return lloyd_optimize_mesh_2_impl(cdt, max_iterations, convergence_ratio,
-      freeze_bound, time_limit, seeds.begin(), seeds.end(), mark);
-  }
-
-  template<typename CDT, typename InputIterator>
-  Mesh_optimization_return_code
-  lloyd_optimize_mesh_2_impl(CDT& cdt,
-                             const int max_iterations,
-                             const double convergence_ratio,
-                             const double freeze_bound,
-                             const double time_limit,
-                             InputIterator seeds_begin,
-                             InputIterator seeds_end,
-                             const bool mark)
-  {
-    typedef Mesh_2::Mesh_sizing_field<CDT>           Sizing;
-    typedef Mesh_2::Lloyd_move_2<CDT, Sizing>        Mv;
-    typedef Mesh_2::Mesh_global_optimizer_2<CDT, Mv> Optimizer;
-
-    Optimizer lloyd(cdt,
-                    convergence_ratio,
-                    freeze_bound);
-    lloyd.set_time_limit(time_limit);
-    lloyd.set_seeds(seeds_begin, seeds_end, mark);
-
-#ifdef CGAL_MESH_2_OPTIMIZERS_DEBUG
-    std::ofstream os("before_lloyd.angles.txt");
-    lloyd.output_angles_histogram(os);
-    os.close();
-#endif
-
-    int nb_iterations = max_iterations;
-
-    //run optimization
-    Mesh_optimization_return_code rc = lloyd(nb_iterations);
-
-#ifdef CGAL_MESH_2_OPTIMIZERS_DEBUG
-    std::ofstream os2("after_lloyd.angles.txt");
-    lloyd.output_angles_histogram(os2);
-    os2.close();
-#endif
-
-    return rc;
-  }
-
 } //end namespace CGAL
 
 CGAL_PRAGMA_DIAG_POP
@@ -0,0 +1,98 @@
+// This file is part of a modified version of CGAL (www.cgal.org).
+//
+// SPDX-License-Identifier: GPL-3.0-or-later OR LicenseRef-Commercial
+//
+// odt_optimize_mesh_2 runs Mesh_global_optimizer_2 with Odt_move_2. Its
+// parameters are those of lloyd_optimize_mesh_2.
+
+#ifndef CGAL_ODT_OPTIMIZE_MESH_2_H
+#define CGAL_ODT_OPTIMIZE_MESH_2_H
+
+#include <CGAL/license/Mesh_2.h>
+
+#include <CGAL/disable_warnings.h>
+
+#include <CGAL/Mesh_2/optimize_mesh_2_impl.h>
+#include <CGAL/Mesh_2/Odt_move_2.h>
+#include <CGAL/Mesh_optimization_return_code.h>
+#include <CGAL/iterator.h>
+#include <CGAL/tags.h>
+#include <CGAL/boost/parameter.h>
+#include <boost/parameter/preprocessor.hpp>
+
+#include <atomic>
+#include <iostream>
+
+// see <CGAL/config.h>
+CGAL_PRAGMA_DIAG_PUSH
+// see <CGAL/boost/parameter.h>
+CGAL_IGNORE_BOOST_PARAMETER_NAME_WARNINGS
+
+
+namespace CGAL
+{
+
+#if defined(BOOST_MSVC)
+#  pragma warning(push)
+#  pragma warning(disable:4003) // not enough actual parameters for macro
+#endif
+
+  BOOST_PARAMETER_FUNCTION(
+  (Mesh_optimization_return_code),
+  odt_optimize_mesh_2,
+  parameters::tag,
+  (required (in_out(cdt),*))
+  (optional
+    (max_iteration_number_, *, 0 )
+    (convergence_, *, 0.001 )
+    (time_limit_, *, 0. )
+    (freeze_bound_, *, 0.001 )
+    (seeds_begin_, *, CGAL::Emptyset_iterator())//see <CGAL/Mesh_2/optimize_mesh_2_impl.h>
+    (seeds_end_, *, CGAL::Emptyset_iterator())//see <CGAL/Mesh_2/optimize_mesh_2_impl.h>
+    (mark_, *, false) //if "false", seeds indicate "outside" regions
+    (pointer_to_stop_atomic_boolean_, *, (std::atomic<bool>*)0)
+    (pointer_to_output_stream_, *, (std::ostream*)0)
+    (concurrency_tag_, *, CGAL::Sequential_tag())
+    (update_policy_, *, Mesh_2::VERTEX_BY_VERTEX_MOVES)
+    (active_set_, *, false)
+    (relaxation_, *, 1.)
+    (anderson_window_, *, 0)
+    (number_of_levels_, *, 1)
+    (smoothing_iterations_, *, 5)
+    (lbfgs_memory_, *, 0)
+  )
+  )
+  {
+    return Mesh_2::internal::optimize_mesh_2_impl<Mesh_2::Odt_move_2>(
+      "odt",
+      cdt,
+      max_iteration_number_,
+      convergence_,
+      freeze_bound_,
+      time_limit_,
+      seeds_begin_,
+      seeds_end_,
+      mark_,
+      pointer_to_stop_atomic_boolean_,
+      pointer_to_output_stream_,
+      concurrency_tag_,
+      update_policy_,
+      active_set_,
+      relaxation_,
+      anderson_window_,
+      number_of_levels_,
+      smoothing_iterations_,
+      lbfgs_memory_);
+  }
+
+#if defined(BOOST_MSVC)
+#  pragma warning(pop)
+#endif
+
+} //end namespace CGAL
+
+CGAL_PRAGMA_DIAG_POP
+
+#include <CGAL/enable_warnings.h>
+
+#endif